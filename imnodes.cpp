@@ -1,7 +1,8 @@
 // the structure of this file:
 //
 // [SECTION] internal data structures
-// [SECTION] global struct
+// [SECTION] geometry kernels
+// [SECTION] context definition
 // [SECTION] editor context definition
 // [SECTION] ui state logic
 // [SECTION] render helpers
@@ -24,15 +25,40 @@
 #include <math.h>
 #include <new>
 #include <stdint.h>
-#include <string.h> // strlen, strncmp
-#include <stdio.h>  // for fwrite, ssprintf, sscanf
+#include <string.h> // strlen, memcpy
+#include <stdio.h>  // for fwrite, fread, ssprintf
 #include <stdlib.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h> // _BitScanForward
+#endif
+
+// Define IMNODES_THREAD_LOCAL as a thread-local storage specifier, such as thread_local or
+// __thread, to give each thread its own current context.
+#if !defined(IMNODES_THREAD_LOCAL)
+#define IMNODES_THREAD_LOCAL
+#endif
+
+#if !defined(IMNODES_DISABLE_SIMD)
+#if defined(__AVX2__)
+#define IMNODES_SIMD
+#define IMNODES_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMNODES_SIMD
+#define IMNODES_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(IMNODES_ENABLE_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define IMNODES_SIMD
+#define IMNODES_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 namespace imnodes
 {
 namespace
 {
-bool initialized = false;
 
 enum ScopeFlags
 {
@@ -42,13 +68,6 @@ enum ScopeFlags
     Scope_Attribute = 1 << 3
 };
 
-enum Channels
-{
-    Channels_NodeBackground = 0,
-    Channels_ImGui,
-    Channels_Count
-};
-
 enum AttributeType
 {
     AttributeType_None,
@@ -64,8 +83,261 @@ enum ElementStateChange
     ElementStateChange_LinkCreated = 1 << 2
 };
 
+// How much of a node is drawn, depending on the node's size on the screen. See
+// Style::node_lod_chrome_size and Style::node_lod_rect_size.
+enum NodeLod
+{
+    NodeLod_Full,
+    NodeLod_Chrome,
+    NodeLod_Rect
+};
+
+// The node's size is only known from its contents, so the contents of a node which is too small to
+// be drawn in full are still submitted once in this many frames.
+const int node_lod_max_skipped_frames = 30;
+
 // [SECTION] internal data structures
 
+inline ImU32 hash_key(const int key)
+{
+    // The finalizer of MurmurHash3. Object ids tend to be small, sequential integers, so the bits
+    // have to be mixed before masking them into a table index.
+    ImU32 h = static_cast<ImU32>(key);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+inline ImU32 hash_key(const ImU64 key)
+{
+    // The 64-bit finalizer of MurmurHash3.
+    ImU64 h = key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<ImU32>(h);
+}
+
+// Maps keys to indices in an object pool. The map uses open addressing with linear probing, and
+// the table is kept at most half full. Erased entries are filled by shifting the following entries
+// of the probe sequence backwards, so the table never contains tombstones.
+//
+// The key type must have a hash_key() overload.
+template<typename Key>
+struct IndexMap
+{
+    struct Entry
+    {
+        Key key;
+        int value;
+    };
+
+    // The number of entries is always a power of two. Empty entries have a negative value.
+    ImVector<Entry> entries;
+    int size;
+
+    IndexMap() : entries(), size(0) {}
+
+    inline int find(const Key key) const
+    {
+        if (entries.empty())
+        {
+            return -1;
+        }
+
+        const int mask = entries.size() - 1;
+        for (int i = static_cast<int>(hash_key(key)) & mask;; i = (i + 1) & mask)
+        {
+            const Entry& entry = entries[i];
+            if (entry.value < 0)
+            {
+                return -1;
+            }
+
+            if (entry.key == key)
+            {
+                return entry.value;
+            }
+        }
+    }
+
+    // Inserts the key, or assigns a new value to it if it already exists. The value must not be
+    // negative.
+    inline void insert(const Key key, const int value)
+    {
+        assert(value >= 0);
+
+        if (2 * (size + 1) > entries.size())
+        {
+            grow();
+        }
+
+        const int mask = entries.size() - 1;
+        for (int i = static_cast<int>(hash_key(key)) & mask;; i = (i + 1) & mask)
+        {
+            Entry& entry = entries[i];
+            if (entry.value < 0)
+            {
+                entry.key = key;
+                entry.value = value;
+                ++size;
+                return;
+            }
+
+            if (entry.key == key)
+            {
+                entry.value = value;
+                return;
+            }
+        }
+    }
+
+    inline void erase(const Key key)
+    {
+        if (entries.empty())
+        {
+            return;
+        }
+
+        const int mask = entries.size() - 1;
+        int hole = static_cast<int>(hash_key(key)) & mask;
+        for (;; hole = (hole + 1) & mask)
+        {
+            const Entry& entry = entries[hole];
+            if (entry.value < 0)
+            {
+                return;
+            }
+
+            if (entry.key == key)
+            {
+                break;
+            }
+        }
+
+        // Move entries of the same probe sequence into the hole, until an entry is found which is
+        // already at its ideal position, or the end of the sequence is reached.
+        for (int i = (hole + 1) & mask;; i = (i + 1) & mask)
+        {
+            const Entry& entry = entries[i];
+            if (entry.value < 0)
+            {
+                break;
+            }
+
+            // The entry can be moved if its ideal slot doesn't lie cyclically in (hole, i].
+            const int ideal = static_cast<int>(hash_key(entry.key)) & mask;
+            const bool can_move =
+                hole <= i ? (ideal <= hole || ideal > i) : (ideal <= hole && ideal > i);
+            if (can_move)
+            {
+                entries[hole] = entry;
+                hole = i;
+            }
+        }
+
+        entries[hole].value = -1;
+        --size;
+    }
+
+    // Grows the table so that it holds count entries without growing again.
+    inline void reserve(const int count)
+    {
+        int new_size = entries.empty() ? 16 : entries.size();
+        while (new_size < 2 * count)
+        {
+            new_size *= 2;
+        }
+
+        if (new_size != entries.size())
+        {
+            rehash(new_size);
+        }
+    }
+
+    // Removes all entries, but keeps the table's memory.
+    inline void clear()
+    {
+        for (int i = 0; i < entries.size(); ++i)
+        {
+            entries[i].value = -1;
+        }
+        size = 0;
+    }
+
+    void grow() { rehash(entries.empty() ? 16 : 2 * entries.size()); }
+
+    void rehash(const int new_size)
+    {
+        ImVector<Entry> old_entries;
+        old_entries.swap(entries);
+
+        entries.resize(new_size);
+        for (int i = 0; i < entries.size(); ++i)
+        {
+            entries[i].value = -1;
+        }
+        size = 0;
+
+        for (int i = 0; i < old_entries.size(); ++i)
+        {
+            const Entry& entry = old_entries[i];
+            if (entry.value >= 0)
+            {
+                insert(entry.key, entry.value);
+            }
+        }
+    }
+};
+
+inline int count_trailing_zeros(const ImU32 bits)
+{
+    assert(bits != 0u);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#else
+    int index = 0;
+    for (ImU32 b = bits; (b & 1u) == 0u; b >>= 1)
+    {
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Returns the index of the first set bit after index `bit`, or -1 if there is none. Pass -1 to
+// find the first set bit.
+inline int bit_vector_next_set(const ImVector<ImU32>& bits, const int bit)
+{
+    const int first = bit + 1;
+    int word = first >> 5;
+    if (word >= bits.size())
+    {
+        return -1;
+    }
+
+    ImU32 word_bits = bits[word] & (~0u << (first & 31));
+    while (word_bits == 0u)
+    {
+        if (++word == bits.size())
+        {
+            return -1;
+        }
+        word_bits = bits[word];
+    }
+
+    return (word << 5) + count_trailing_zeros(word_bits);
+}
+
 // The object T must have the following interface:
 //
 // struct T
@@ -74,216 +346,622 @@ enum ElementStateChange
 //
 //     int id;
 // };
+//
+// Objects which aren't submitted during a frame are released at the start of the next frame. Slot
+// liveness is stored in bit vectors, so that loops over the objects in use can skip 32 slots at a
+// time, and released slots are added to the free list as they die.
+//
+// Iterate over the objects which are in use like this:
+//
+//   for (int i = pool.first_in_use(); i != -1; i = pool.next_in_use(i))
 template<typename T>
 struct ObjectPool
 {
     ImVector<T> pool;
-    ImVector<bool> in_use;
+    // One bit per slot. Set when the object is submitted during the current frame.
+    ImVector<ImU32> in_use;
+    // One bit per slot. Set when the slot holds an object, i.e. the object's id is in the id map.
+    ImVector<ImU32> allocated;
     ImVector<int> free_list;
-    ImGuiStorage id_map;
+    IndexMap<int> id_map;
+
+    ObjectPool() : pool(), in_use(), allocated(), free_list(), id_map() {}
 
-    ObjectPool() : pool(), in_use(), free_list(), id_map() {}
+    // ImVector doesn't destroy its elements, and the objects own buffers of their own, e.g. the
+    // cached geometry of a node or the points of a link's curve. The freed slots are destroyed as
+    // well, because they still hold the buffers of the objects which last used them.
+    ~ObjectPool()
+    {
+        for (int i = 0; i < pool.size(); ++i)
+        {
+            pool[i].~T();
+        }
+    }
 
     inline void update()
     {
-        free_list.clear();
-        for (int i = 0; i < in_use.size(); ++i)
+        for (int word = 0; word < in_use.size(); ++word)
         {
-            if (!in_use[i])
+            // Release the objects which weren't submitted during the previous frame.
+            ImU32 released = allocated[word] & ~in_use[word];
+            while (released != 0u)
             {
-                id_map.SetInt(pool[i].id, -1);
-                free_list.push_back(i);
+                const int index = (word << 5) + count_trailing_zeros(released);
+                id_map.erase(pool[index].id);
+                free_list.push_back(index);
+                released &= released - 1u;
             }
+
+            allocated[word] = in_use[word];
+            in_use[word] = 0u;
         }
-        // set all values to false
-        memset(in_use.Data, 0, sizeof(bool) * in_use.size());
     }
 
+    inline bool is_in_use(const int index) const { return ImBitArrayTestBit(in_use.Data, index); }
+
+    inline void mark_in_use(const int index) { ImBitArraySetBit(in_use.Data, index); }
+
+    inline int first_in_use() const { return bit_vector_next_set(in_use, -1); }
+
+    inline int next_in_use(const int index) const { return bit_vector_next_set(in_use, index); }
+
     inline int find_or_create_index_for(const int id)
     {
-        int index = id_map.GetInt(static_cast<ImGuiID>(id), -1);
+        int index = id_map.find(id);
         if (index == -1)
         {
             if (free_list.empty())
             {
                 index = pool.size();
                 pool.push_back(T());
-                in_use.push_back(true);
+                if ((index >> 5) == in_use.size())
+                {
+                    in_use.push_back(0u);
+                    allocated.push_back(0u);
+                }
             }
             else
             {
                 index = free_list.back();
                 free_list.pop_back();
+                // Don't let the new object inherit the state of the object which used the slot
+                // before it.
+                pool[index] = T();
             }
-            id_map.SetInt(static_cast<ImGuiID>(id), index);
+            // The id is needed to release the slot, even if the caller never assigns it.
+            pool[index].id = id;
+            id_map.insert(id, index);
         }
-        in_use[index] = true;
+        mark_in_use(index);
         return index;
     }
 
-    inline T& find_or_create_new(const int id)
+    // Reserves memory for count objects, so that they can be created without growing the pool.
+    inline void reserve(const int count)
     {
-        const int index = find_or_create_index_for(id);
-        return pool[index];
+        pool.reserve(count);
+        in_use.reserve((count + 31) >> 5);
+        allocated.reserve((count + 31) >> 5);
+        id_map.reserve(count);
     }
 
-    // Predicate must define operator()(const T& lhs, const T& operator) ->
-    // bool.
-    template<typename Predicate>
-    inline bool contains(const T& v, Predicate predicate) const
+    inline T& find_or_create_new(const int id)
     {
-        for (int i = 0; i < pool.size(); ++i)
-        {
-            if (!in_use[i])
-            {
-                continue;
-            }
-
-            if (predicate(v, pool[i]))
-            {
-                return true;
-            }
-        }
-
-        return false;
+        const int index = find_or_create_index_for(id);
+        return pool[index];
     }
 };
 
-// Emulates std::optional<int> using the sentinel value `invalid_index`.
-struct OptionalIndex
+// A list of selected pool indices. The indices are kept in the order in which they were selected,
+// and a bit per pool slot allows testing for membership in constant time.
+struct IndexSelection
 {
-    OptionalIndex() : m_index(invalid_index) {}
-    OptionalIndex(const int value) : m_index(value) {}
+    ImVector<int> indices;
+    ImVector<ImU32> bits;
 
-    // Observers
+    IndexSelection() : indices(), bits() {}
 
-    inline bool has_value() const { return m_index != invalid_index; }
+    inline int size() const { return indices.size(); }
 
-    inline int value() const
+    inline int operator[](const int i) const { return indices[i]; }
+
+    inline bool contains(const int index) const
     {
-        assert(has_value());
-        return m_index;
+        return (index >> 5) < bits.size() && ImBitArrayTestBit(bits.Data, index);
     }
 
-    // Modifiers
-
-    inline OptionalIndex& operator=(const int value)
+    inline void push_back(const int index)
     {
-        m_index = value;
-        return *this;
+        const int num_words = (index >> 5) + 1;
+        if (bits.size() < num_words)
+        {
+            const int old_size = bits.size();
+            bits.resize(num_words);
+            memset(bits.Data + old_size, 0, sizeof(ImU32) * (num_words - old_size));
+        }
+        ImBitArraySetBit(bits.Data, index);
+        indices.push_back(index);
     }
 
-    inline void reset() { m_index = invalid_index; }
-
-    inline bool operator==(const OptionalIndex& rhs) const { return m_index == rhs.m_index; }
-
-    inline bool operator==(const int rhs) const { return m_index == rhs; }
-
-    static const int invalid_index = -1;
-
-private:
-    int m_index;
+    // Only the bits of the selected indices are cleared, so this is proportional to the size of
+    // the selection rather than the size of the pool.
+    inline void clear()
+    {
+        for (int i = 0; i < indices.size(); ++i)
+        {
+            ImBitArrayClearBit(bits.Data, indices[i]);
+        }
+        indices.resize(0);
+    }
 };
 
-struct NodeData
-{
-    int id;
-    ImVec2 origin; // The node origin is in editor space
-    ImRect title_bar_content_rect;
-    ImRect rect;
+// The node grid's cell size, until the editor has submitted nodes to measure.
+const float default_node_grid_cell_size = 128.f;
 
-    struct
+// A uniform grid of square cells, which is used to find the elements under the mouse cursor without
+// testing every element. The cells are stored sparsely in a hash map, and each cell holds a linked
+// list of the elements which overlap it. The grid is rebuilt every frame.
+struct SpatialGrid
+{
+    struct Entry
     {
-        ImU32 background, background_hovered, background_selected, outline, titlebar,
-            titlebar_hovered, titlebar_selected;
-    } color_style;
-
-    struct
+        // The pool index of the element.
+        int index;
+        // The submission order of the node that the element belongs to.
+        int order;
+        // The next entry in the same cell, or -1.
+        int next;
+    };
+
+    // Elements which would cover more cells than this are kept in a separate list instead, which
+    // every query walks.
+    static const int max_cells_per_element = 64;
+
+    float cell_size;
+    // Maps a cell to the most recently inserted entry in it.
+    IndexMap<ImU64> cells;
+    // The entries are stored in insertion order.
+    ImVector<Entry> entries;
+    // The most recently inserted entry of an element which covers too many cells, or -1.
+    int oversized;
+
+    SpatialGrid() : cell_size(1.f), cells(), entries(), oversized(-1) {}
+
+    inline void reset(const float size)
     {
-        float corner_rounding;
-        ImVec2 padding;
-    } layout_style;
-
-    ImVector<int> pin_indices;
-    bool draggable;
+        cell_size = size > 1.f ? size : 1.f;
+        cells.clear();
+        entries.resize(0);
+        oversized = -1;
+    }
 
-    NodeData()
-        : id(0), origin(100.0f, 100.0f), title_bar_content_rect(),
-          rect(ImVec2(0.0f, 0.0f), ImVec2(0.0f, 0.0f)), color_style(), layout_style(),
-          pin_indices(), draggable(true)
+    inline int cell_coordinate(const float x) const
     {
+        return static_cast<int>(floorf(x / cell_size));
     }
-};
 
-struct PinData
-{
-    int id;
-    int parent_node_idx;
-    ImRect attribute_rect;
-    AttributeType type;
-    PinShape shape;
-    ImVec2 pos; // screen-space coordinates
-    int flags;
+    static inline ImU64 cell_key(const int x, const int y)
+    {
+        return (static_cast<ImU64>(static_cast<ImU32>(x)) << 32) |
+               static_cast<ImU64>(static_cast<ImU32>(y));
+    }
 
-    struct
+    inline void insert(const ImRect& rect, const int index, const int order)
     {
-        ImU32 background, hovered;
-    } color_style;
+        const int x_min = cell_coordinate(rect.Min.x);
+        const int x_max = cell_coordinate(rect.Max.x);
+        const int y_min = cell_coordinate(rect.Min.y);
+        const int y_max = cell_coordinate(rect.Max.y);
+
+        Entry entry;
+        entry.index = index;
+        entry.order = order;
+        if ((ImS64)(x_max - x_min + 1) * (ImS64)(y_max - y_min + 1) > max_cells_per_element)
+        {
+            entry.next = oversized;
+            oversized = entries.size();
+            entries.push_back(entry);
+            return;
+        }
 
-    PinData()
-        : id(), parent_node_idx(), attribute_rect(), type(AttributeType_None),
-          shape(PinShape_CircleFilled), pos(), flags(AttributeFlags_None), color_style()
+        for (int y = y_min; y <= y_max; ++y)
+        {
+            for (int x = x_min; x <= x_max; ++x)
+            {
+                const ImU64 key = cell_key(x, y);
+                entry.next = cells.find(key);
+                cells.insert(key, entries.size());
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    // Returns the most recently inserted entry in the cell containing the point, or -1. Walk the
+    // rest of the cell with Entry::next. The oversized elements aren't included.
+    inline int find_cell(const ImVec2& point) const
     {
+        if (entries.empty())
+        {
+            return -1;
+        }
+        return cells.find(cell_key(cell_coordinate(point.x), cell_coordinate(point.y)));
     }
 };
 
-struct LinkData
+inline bool rects_equal(const ImRect& a, const ImRect& b)
 {
-    int id;
-    int start_pin_idx, end_pin_idx;
-
-    struct
-    {
-        ImU32 base, hovered, selected;
-    } color_style;
-
-    LinkData() : id(), start_pin_idx(), end_pin_idx(), color_style() {}
-};
+    return a.Min.x == b.Min.x && a.Min.y == b.Min.y && a.Max.x == b.Max.x && a.Max.y == b.Max.y;
+}
 
-struct LinkPredicate
+// A bounding volume hierarchy over the link rectangles, which lets queries visit only the links
+// whose rectangles overlap the query rectangle. The rectangles are stored in grid space, so that
+// panning doesn't move them. The tree is rebuilt when links are created or destroyed. When a link
+// moves, its leaf is refit, and the change propagates upwards until an ancestor's bounds stay
+// the same.
+struct LinkBvh
 {
-    bool operator()(const LinkData& lhs, const LinkData& rhs) const
+    struct Item
     {
-        // Do a unique compare by sorting the pins' addresses.
-        // This catches duplicate links, whether they are in the
-        // same direction or not.
-        // Sorting by pin index should have the uniqueness guarantees as sorting
-        // by id -- each unique id will get one slot in the link pool array.
-
-        int lhs_start = lhs.start_pin_idx;
-        int lhs_end = lhs.end_pin_idx;
-        int rhs_start = rhs.start_pin_idx;
-        int rhs_end = rhs.end_pin_idx;
+        ImRect bounds;
+        int link_idx;
+    };
 
-        if (lhs_start > lhs_end)
+    struct Node
+    {
+        ImRect bounds;
+        int parent;
+        // The children are -1 for leaf nodes.
+        int left, right;
+        // Only valid for leaf nodes.
+        int link_idx;
+    };
+
+    ImVector<Node> nodes;
+    // Maps a link index to its leaf node, or -1 if the link isn't in the tree.
+    ImVector<int> link_leaves;
+    // The link pool's in_use bits at the time of the last build.
+    ImVector<ImU32> link_set;
+
+    LinkBvh() : nodes(), link_leaves(), link_set() {}
+
+    inline void build(ImVector<Item>& items, const int link_pool_size)
+    {
+        nodes.resize(0);
+        link_leaves.resize(link_pool_size);
+        for (int i = 0; i < link_leaves.size(); ++i)
         {
-            ImSwap(lhs_start, lhs_end);
+            link_leaves[i] = -1;
         }
 
-        if (rhs_start > rhs_end)
+        if (!items.empty())
         {
-            ImSwap(rhs_start, rhs_end);
+            nodes.reserve(2 * items.size() - 1);
+            build_range(items.Data, items.size(), -1);
         }
+    }
 
-        return lhs_start == rhs_start && lhs_end == rhs_end;
+    inline bool contains(const int link_idx) const
+    {
+        return link_idx < link_leaves.size() && link_leaves[link_idx] != -1;
     }
-};
 
-struct BezierCurve
-{
-    // the curve control points
-    ImVec2 p0, p1, p2, p3;
-};
+    inline void refit(const int link_idx, const ImRect& bounds)
+    {
+        int node_idx = link_leaves[link_idx];
+        if (rects_equal(nodes[node_idx].bounds, bounds))
+        {
+            return;
+        }
+        nodes[node_idx].bounds = bounds;
+
+        for (node_idx = nodes[node_idx].parent; node_idx != -1; node_idx = nodes[node_idx].parent)
+        {
+            Node& node = nodes[node_idx];
+            ImRect union_bounds = nodes[node.left].bounds;
+            union_bounds.Add(nodes[node.right].bounds);
+            if (rects_equal(node.bounds, union_bounds))
+            {
+                break;
+            }
+            node.bounds = union_bounds;
+        }
+    }
+
+    // Appends the indices of the links whose rectangles overlap the query rectangle, in no
+    // particular order.
+    inline void query(const ImRect& rect, ImVector<int>& link_indices) const
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+
+        // The tree is balanced, so the stack never gets deeper than the height of the tree.
+        int stack[64];
+        int stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (!rect.Overlaps(node.bounds))
+            {
+                continue;
+            }
+
+            if (node.left == -1)
+            {
+                link_indices.push_back(node.link_idx);
+            }
+            else
+            {
+                IM_ASSERT(stack_size + 2 <= IM_ARRAYSIZE(stack));
+                stack[stack_size++] = node.right;
+                stack[stack_size++] = node.left;
+            }
+        }
+    }
+
+private:
+    static inline float item_center(const Item& item, const int axis)
+    {
+        return axis == 0 ? item.bounds.Min.x + item.bounds.Max.x
+                         : item.bounds.Min.y + item.bounds.Max.y;
+    }
+
+    // Reorders the items so that the k-th item is in its sorted position along the axis, with
+    // smaller items before it and larger items after it.
+    static void select_item(Item* const items, const int count, const int k, const int axis)
+    {
+        int lo = 0;
+        int hi = count - 1;
+        while (lo < hi)
+        {
+            const float pivot = item_center(items[(lo + hi) / 2], axis);
+            int i = lo;
+            int j = hi;
+            while (i <= j)
+            {
+                while (item_center(items[i], axis) < pivot)
+                {
+                    ++i;
+                }
+                while (item_center(items[j], axis) > pivot)
+                {
+                    --j;
+                }
+                if (i <= j)
+                {
+                    ImSwap(items[i], items[j]);
+                    ++i;
+                    --j;
+                }
+            }
+
+            if (k <= j)
+            {
+                hi = j;
+            }
+            else if (k >= i)
+            {
+                lo = i;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    // Splits the items at the median of the longest axis of their centers.
+    int build_range(Item* const items, const int count, const int parent)
+    {
+        const int node_idx = nodes.size();
+        nodes.push_back(Node());
+
+        Node node;
+        node.parent = parent;
+        node.left = -1;
+        node.right = -1;
+        node.link_idx = -1;
+
+        if (count == 1)
+        {
+            node.bounds = items[0].bounds;
+            node.link_idx = items[0].link_idx;
+            link_leaves[node.link_idx] = node_idx;
+        }
+        else
+        {
+            ImRect centers(items[0].bounds.GetCenter(), items[0].bounds.GetCenter());
+            for (int i = 1; i < count; ++i)
+            {
+                centers.Add(items[i].bounds.GetCenter());
+            }
+
+            const int axis = centers.GetWidth() >= centers.GetHeight() ? 0 : 1;
+            const int half = count / 2;
+            select_item(items, count, half, axis);
+
+            node.left = build_range(items, half, node_idx);
+            node.right = build_range(items + half, count - half, node_idx);
+            node.bounds = nodes[node.left].bounds;
+            node.bounds.Add(nodes[node.right].bounds);
+        }
+
+        nodes[node_idx] = node;
+        return node_idx;
+    }
+};
+
+// Emulates std::optional<int> using the sentinel value `invalid_index`.
+struct OptionalIndex
+{
+    OptionalIndex() : m_index(invalid_index) {}
+    OptionalIndex(const int value) : m_index(value) {}
+
+    // Observers
+
+    inline bool has_value() const { return m_index != invalid_index; }
+
+    inline int value() const
+    {
+        assert(has_value());
+        return m_index;
+    }
+
+    // Modifiers
+
+    inline OptionalIndex& operator=(const int value)
+    {
+        m_index = value;
+        return *this;
+    }
+
+    inline void reset() { m_index = invalid_index; }
+
+    inline bool operator==(const OptionalIndex& rhs) const { return m_index == rhs.m_index; }
+
+    inline bool operator==(const int rhs) const { return m_index == rhs; }
+
+    static const int invalid_index = -1;
+
+private:
+    int m_index;
+};
+
+// The inputs which a node's background, title bar and outline geometry depend on. The rectangles
+// are relative to the node's top left corner, so that moving or panning the node doesn't change
+// the key.
+struct NodeChromeKey
+{
+    ImVec2 size;
+    ImRect title_bar_rect;
+    ImU32 background, titlebar, outline;
+    float corner_rounding;
+    bool draw_outline;
+    ImDrawListFlags draw_list_flags;
+    ImVec2 white_pixel_uv;
+
+    bool operator==(const NodeChromeKey& rhs) const
+    {
+        return size.x == rhs.size.x && size.y == rhs.size.y &&
+               title_bar_rect.Min.x == rhs.title_bar_rect.Min.x &&
+               title_bar_rect.Min.y == rhs.title_bar_rect.Min.y &&
+               title_bar_rect.Max.x == rhs.title_bar_rect.Max.x &&
+               title_bar_rect.Max.y == rhs.title_bar_rect.Max.y && background == rhs.background &&
+               titlebar == rhs.titlebar && outline == rhs.outline &&
+               corner_rounding == rhs.corner_rounding && draw_outline == rhs.draw_outline &&
+               draw_list_flags == rhs.draw_list_flags &&
+               white_pixel_uv.x == rhs.white_pixel_uv.x && white_pixel_uv.y == rhs.white_pixel_uv.y;
+    }
+};
+
+// The tessellated chrome of a node, relative to the node's top left corner. The geometry is
+// replayed with a translation for as long as the key stays the same.
+struct NodeChromeCache
+{
+    NodeChromeKey key;
+    bool valid;
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;
+
+    NodeChromeCache() : key(), valid(false), vertices(), indices() {}
+};
+
+// A draw command of a node's recorded ImGui content.
+struct NodeContentCommand
+{
+    // Relative to the node's top left corner, unless the command was clipped to the canvas.
+    ImVec4 clip_rect;
+    bool canvas_clip;
+    ImTextureID texture_id;
+    int elem_count;
+};
+
+// The ImGui output of a NodeFlags_Cacheable node, relative to the node's top left corner. The
+// snapshot is replayed instead of the node's contents until it's invalidated.
+struct NodeContentSnapshot
+{
+    bool valid;
+    ImDrawListFlags draw_list_flags;
+    ImVec2 white_pixel_uv;
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;
+    ImVector<NodeContentCommand> commands;
+
+    NodeContentSnapshot()
+        : valid(false), draw_list_flags(ImDrawListFlags_None), white_pixel_uv(), vertices(),
+          indices(), commands()
+    {
+    }
+};
+
+struct NodeData
+{
+    int id;
+    ImVec2 origin; // The node origin is in editor space
+    ImRect title_bar_content_rect;
+    ImRect rect;
+
+    struct
+    {
+        ImU32 background, background_hovered, background_selected, outline, titlebar,
+            titlebar_hovered, titlebar_selected;
+    } color_style;
+
+    struct
+    {
+        float corner_rounding;
+        ImVec2 padding;
+    } layout_style;
+
+    ImVector<int> pin_indices;
+    bool draggable;
+
+    NodeChromeCache chrome_cache;
+    NodeContentSnapshot content_snapshot;
+    // Set when one of the node's ImGui items was active during the node's last live submission.
+    bool content_active;
+    // The number of consecutive frames in which the node's contents were skipped because of its
+    // level of detail.
+    int lod_skipped_frames;
+
+    NodeData()
+        : id(0), origin(100.0f, 100.0f), title_bar_content_rect(),
+          rect(ImVec2(0.0f, 0.0f), ImVec2(0.0f, 0.0f)), color_style(), layout_style(),
+          pin_indices(), draggable(true), chrome_cache(), content_snapshot(),
+          content_active(false), lod_skipped_frames(0)
+    {
+    }
+};
+
+struct PinData
+{
+    int id;
+    int parent_node_idx;
+    ImRect attribute_rect;
+    AttributeType type;
+    PinShape shape;
+    ImVec2 pos; // screen-space coordinates
+    int flags;
+
+    struct
+    {
+        ImU32 background, hovered;
+    } color_style;
+
+    PinData()
+        : id(), parent_node_idx(), attribute_rect(), type(AttributeType_None),
+          shape(PinShape_CircleFilled), pos(), flags(AttributeFlags_None), color_style()
+    {
+    }
+};
+
+struct BezierCurve
+{
+    // the curve control points
+    ImVec2 p0, p1, p2, p3;
+};
 
 struct LinkBezierData
 {
@@ -291,6 +969,55 @@ struct LinkBezierData
     int num_segments;
 };
 
+// A link's curve, flattened into a polyline in grid space. The polyline is shared by hovering, box
+// selection and rendering, and it is only rebuilt when the endpoints or the style change.
+struct LinkCurve
+{
+    // The endpoints and style which the polyline was built for.
+    ImVec2 start, end;
+    AttributeType start_type;
+    float line_segments_per_length;
+    // Zero when the link is flattened with a fixed number of segments.
+    float flattening_tolerance;
+
+    BezierCurve bezier;
+    ImVector<ImVec2> points;
+
+    LinkCurve()
+        : start(), end(), start_type(AttributeType_None), line_segments_per_length(0.f),
+          flattening_tolerance(0.f), bezier(), points()
+    {
+    }
+};
+
+struct LinkData
+{
+    int id;
+    int start_pin_idx, end_pin_idx;
+
+    struct
+    {
+        ImU32 base, hovered, selected;
+    } color_style;
+
+    LinkCurve curve;
+
+    LinkData() : id(), start_pin_idx(), end_pin_idx(), color_style(), curve() {}
+};
+
+// Links are identified by their pair of pins, regardless of the direction of the link. Sorting by
+// pin index has the same uniqueness guarantees as sorting by id -- each unique id gets one slot in
+// the pin pool.
+inline ImU64 make_pin_pair_key(int start_pin_idx, int end_pin_idx)
+{
+    if (start_pin_idx > end_pin_idx)
+    {
+        ImSwap(start_pin_idx, end_pin_idx);
+    }
+    return (static_cast<ImU64>(static_cast<ImU32>(start_pin_idx)) << 32) |
+           static_cast<ImU64>(static_cast<ImU32>(end_pin_idx));
+}
+
 enum ClickInteractionType
 {
     ClickInteractionType_Node,
@@ -338,61 +1065,106 @@ struct StyleElement
     StyleElement(const float value, const StyleVar variable) : item(variable), value(value) {}
 };
 
-// [SECTION] global struct
-// this stores data which only lives for one frame
-struct
+// The tessellated geometry of a pin shape, centered on the origin. The vertex colors are white,
+// or transparent white on the anti-aliased fringe, so that the pin color can be applied with a
+// bitwise and.
+struct PinStamp
 {
-    EditorContext* default_editor_ctx;
-    EditorContext* editor_ctx;
-    ImDrawList* canvas_draw_list;
-    ImVec2 canvas_origin_screen_space;
-    ImRect canvas_rect_screen_space;
-    ScopeFlags current_scope;
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;
+};
 
-    IO io;
-    Style style;
-    ImVector<ColorStyleElement> color_modifier_stack;
-    ImVector<StyleElement> style_modifier_stack;
-    ImGuiTextBuffer text_buffer;
+// The inputs which the pin stamp geometry depends on. The stamps are rebuilt when any of these
+// change.
+struct PinStampKey
+{
+    float circle_radius;
+    float quad_side_length;
+    float triangle_side_length;
+    float line_thickness;
+    ImDrawListFlags draw_list_flags;
+    ImVec2 white_pixel_uv;
+
+    bool operator==(const PinStampKey& rhs) const
+    {
+        return circle_radius == rhs.circle_radius && quad_side_length == rhs.quad_side_length &&
+               triangle_side_length == rhs.triangle_side_length &&
+               line_thickness == rhs.line_thickness && draw_list_flags == rhs.draw_list_flags &&
+               white_pixel_uv.x == rhs.white_pixel_uv.x && white_pixel_uv.y == rhs.white_pixel_uv.y;
+    }
+};
 
-    int current_attribute_flags;
-    ImVector<int> attribute_flag_stack;
+// A link which is drawn this frame, and the color it is drawn with.
+struct LinkDrawItem
+{
+    int link_idx;
+    ImU32 color;
 
-    int current_node_idx;
-    int current_pin_idx;
-    int current_attribute_id;
+    LinkDrawItem(const int link_idx, const ImU32 color) : link_idx(link_idx), color(color) {}
+};
 
-    OptionalIndex hovered_node_idx;
-    OptionalIndex hovered_link_idx;
-    OptionalIndex hovered_pin_idx;
-    int hovered_pin_flags;
+// The draw list of a job which builds link or node geometry, and the job's scratch space. Before
+// the job runs, the main thread reserves the most vertices, indices and scratch points which the
+// job's items can add, so that the job never allocates memory.
+struct DrawJob
+{
+    ImDrawList* draw_list;
+    ImVector<ImVec2> points;
+    int reserved_vertices;
+    int reserved_indices;
+    int reserved_points;
+
+    DrawJob(const ImDrawListSharedData* shared_data)
+        : draw_list(IM_NEW(ImDrawList)(shared_data)), points(), reserved_vertices(0),
+          reserved_indices(0), reserved_points(0)
+    {
+    }
+    ~DrawJob() { IM_DELETE(draw_list); }
+};
 
-    OptionalIndex deleted_link_idx;
-    OptionalIndex snap_link_idx;
+// The geometry which a job built for one link or node, as ranges of its draw list's buffers. The
+// indices are relative to first_idx. If the item can't be drawn without allocating memory, or if
+// the draw list's vertex index range was reset while the geometry was built, the item isn't valid,
+// and the link or node is drawn on the main thread instead.
+struct DrawJobItem
+{
+    int first_vertex;
+    int vertex_count;
+    int first_index;
+    int index_count;
+    unsigned int first_idx;
+    bool valid;
+};
 
-    int element_state_change;
+// The INI section whose key-value lines are being loaded.
+enum IniSection
+{
+    IniSection_None,
+    IniSection_Editor,
+    IniSection_Node
+};
 
-    int active_attribute_id;
-    bool active_attribute;
+// The state of an INI load which may be split into chunks. Lines are parsed in place, except for a
+// line which is split between two chunks. That line is collected in partial_line.
+struct IniLoadState
+{
+    EditorContext* editor;
+    IniSection section;
+    // The node whose section is being loaded, or -1.
+    int node_idx;
+    ImGuiTextBuffer partial_line;
 
-    bool left_mouse_clicked;
-    bool left_mouse_released;
-    bool middle_mouse_clicked;
-    bool left_mouse_dragging;
-    bool middle_mouse_dragging;
-} g;
+    IniLoadState() : editor(NULL), section(IniSection_None), node_idx(-1), partial_line() {}
+};
 
-EditorContext& editor_context_get()
-{
-    assert(g.editor_ctx != NULL);
-    return *g.editor_ctx;
-}
+// [SECTION] geometry kernels
 
-inline bool is_mouse_hovering_near_point(const ImVec2& point, float radius)
-{
-    ImVec2 delta = ImGui::GetIO().MousePos - point;
-    return (delta.x * delta.x + delta.y * delta.y) < (radius * radius);
-}
+// The geometry helpers which run over many bezier parameters, polyline segments or points at a
+// time have batched versions here. The instruction set is selected at compile time: AVX2 if the
+// compiler targets it, otherwise SSE2, and otherwise the scalar helpers. The NEON path isn't built
+// by CI, so it's only used if IMNODES_ENABLE_NEON is defined. Define IMNODES_DISABLE_SIMD to always
+// use the scalar helpers. The vector paths perform the same floating point operations in the same
+// order as the scalar helpers.
 
 inline ImVec2 eval_bezier(float t, const BezierCurve& bezier)
 {
@@ -404,101 +1176,6 @@ inline ImVec2 eval_bezier(float t, const BezierCurve& bezier)
             3 * (1 - t) * t * t * bezier.p2.y + t * t * t * bezier.p3.y);
 }
 
-// Calculates the closest point along each bezier curve segment.
-ImVec2 get_closest_point_on_cubic_bezier(
-    const int num_segments,
-    const ImVec2& p,
-    const BezierCurve& bezier)
-{
-    IM_ASSERT(num_segments > 0);
-    ImVec2 p_last = bezier.p0;
-    ImVec2 p_closest;
-    float p_closest_dist = FLT_MAX;
-    float t_step = 1.0f / (float)num_segments;
-    for (int i = 1; i <= num_segments; ++i)
-    {
-        ImVec2 p_current = eval_bezier(t_step * i, bezier);
-        ImVec2 p_line = ImLineClosestPoint(p_last, p_current, p);
-        float dist = ImLengthSqr(p - p_line);
-        if (dist < p_closest_dist)
-        {
-            p_closest = p_line;
-            p_closest_dist = dist;
-        }
-        p_last = p_current;
-    }
-    return p_closest;
-}
-
-inline float get_distance_to_cubic_bezier(
-    const ImVec2& pos,
-    const BezierCurve& bezier,
-    const int num_segments)
-{
-    const ImVec2 point_on_curve = get_closest_point_on_cubic_bezier(num_segments, pos, bezier);
-
-    const ImVec2 to_curve = point_on_curve - pos;
-    return ImSqrt(ImLengthSqr(to_curve));
-}
-
-inline ImRect get_containing_rect_for_bezier_curve(const BezierCurve& bezier)
-{
-    const ImVec2 min = ImVec2(ImMin(bezier.p0.x, bezier.p3.x), ImMin(bezier.p0.y, bezier.p3.y));
-    const ImVec2 max = ImVec2(ImMax(bezier.p0.x, bezier.p3.x), ImMax(bezier.p0.y, bezier.p3.y));
-
-    const float hover_distance = g.style.link_hover_distance;
-
-    ImRect rect(min, max);
-    rect.Add(bezier.p1);
-    rect.Add(bezier.p2);
-    rect.Expand(ImVec2(hover_distance, hover_distance));
-
-    return rect;
-}
-
-inline LinkBezierData get_link_renderable(
-    ImVec2 start,
-    ImVec2 end,
-    const AttributeType start_type,
-    const float line_segments_per_length)
-{
-    assert((start_type == AttributeType_Input) || (start_type == AttributeType_Output));
-    if (start_type == AttributeType_Input)
-    {
-        ImSwap(start, end);
-    }
-
-    const float link_length = ImSqrt(ImLengthSqr(end - start));
-    const ImVec2 offset = ImVec2(0.25f * link_length, 0.f);
-    LinkBezierData link_data;
-    link_data.bezier.p0 = start;
-    link_data.bezier.p1 = start + offset;
-    link_data.bezier.p2 = end - offset;
-    link_data.bezier.p3 = end;
-    link_data.num_segments = ImMax(static_cast<int>(link_length * line_segments_per_length), 1);
-    return link_data;
-}
-
-inline bool is_mouse_hovering_near_link(const BezierCurve& bezier, const int num_segments)
-{
-    const ImVec2 mouse_pos = ImGui::GetIO().MousePos;
-
-    // First, do a simple bounding box test against the box containing the link
-    // to see whether calculating the distance to the link is worth doing.
-    const ImRect link_rect = get_containing_rect_for_bezier_curve(bezier);
-
-    if (link_rect.Contains(mouse_pos))
-    {
-        const float distance = get_distance_to_cubic_bezier(mouse_pos, bezier, num_segments);
-        if (distance < g.style.link_hover_distance)
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 inline float eval_implicit_line_eq(const ImVec2& p1, const ImVec2& p2, const ImVec2& p)
 {
     return (p2.y - p1.y) * p.x + (p1.x - p2.x) * p.y + (p2.x * p1.y - p1.x * p2.y);
@@ -577,820 +1254,2742 @@ inline bool rectangle_overlaps_line_segment(const ImRect& rect, const ImVec2& p1
     return false;
 }
 
-inline bool rectangle_overlaps_bezier(const ImRect& rectangle, const LinkBezierData& link_data)
+#if defined(IMNODES_SIMD_AVX2)
+typedef __m256 simd_float;
+typedef __m256 simd_mask;
+const int simd_width = 8;
+
+inline simd_float simd_set1(const float v) { return _mm256_set1_ps(v); }
+inline simd_float simd_load(const float* const p) { return _mm256_loadu_ps(p); }
+inline void simd_store(float* const p, const simd_float v) { _mm256_storeu_ps(p, v); }
+inline simd_float simd_add(const simd_float a, const simd_float b) { return _mm256_add_ps(a, b); }
+inline simd_float simd_sub(const simd_float a, const simd_float b) { return _mm256_sub_ps(a, b); }
+inline simd_float simd_mul(const simd_float a, const simd_float b) { return _mm256_mul_ps(a, b); }
+inline simd_mask simd_cmplt(const simd_float a, const simd_float b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+inline simd_mask simd_cmpge(const simd_float a, const simd_float b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+}
+inline simd_mask simd_and(const simd_mask a, const simd_mask b) { return _mm256_and_ps(a, b); }
+inline simd_mask simd_or(const simd_mask a, const simd_mask b) { return _mm256_or_ps(a, b); }
+inline simd_mask simd_xor(const simd_mask a, const simd_mask b) { return _mm256_xor_ps(a, b); }
+inline bool simd_any(const simd_mask m) { return _mm256_movemask_ps(m) != 0; }
+// Loads the x and y coordinates of simd_width consecutive points.
+inline void simd_load_points(const ImVec2* const p, simd_float& xs, simd_float& ys)
+{
+    const __m256 a = _mm256_loadu_ps(&p[0].x);
+    const __m256 b = _mm256_loadu_ps(&p[4].x);
+    // The shuffles work within 128-bit halves, which leaves the 64-bit quarters out of order.
+    const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    xs = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), order);
+    ys = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), order);
+}
+#elif defined(IMNODES_SIMD_SSE2)
+typedef __m128 simd_float;
+typedef __m128 simd_mask;
+const int simd_width = 4;
+
+inline simd_float simd_set1(const float v) { return _mm_set1_ps(v); }
+inline simd_float simd_load(const float* const p) { return _mm_loadu_ps(p); }
+inline void simd_store(float* const p, const simd_float v) { _mm_storeu_ps(p, v); }
+inline simd_float simd_add(const simd_float a, const simd_float b) { return _mm_add_ps(a, b); }
+inline simd_float simd_sub(const simd_float a, const simd_float b) { return _mm_sub_ps(a, b); }
+inline simd_float simd_mul(const simd_float a, const simd_float b) { return _mm_mul_ps(a, b); }
+inline simd_mask simd_cmplt(const simd_float a, const simd_float b) { return _mm_cmplt_ps(a, b); }
+inline simd_mask simd_cmpge(const simd_float a, const simd_float b) { return _mm_cmpge_ps(a, b); }
+inline simd_mask simd_and(const simd_mask a, const simd_mask b) { return _mm_and_ps(a, b); }
+inline simd_mask simd_or(const simd_mask a, const simd_mask b) { return _mm_or_ps(a, b); }
+inline simd_mask simd_xor(const simd_mask a, const simd_mask b) { return _mm_xor_ps(a, b); }
+inline bool simd_any(const simd_mask m) { return _mm_movemask_ps(m) != 0; }
+// Loads the x and y coordinates of simd_width consecutive points.
+inline void simd_load_points(const ImVec2* const p, simd_float& xs, simd_float& ys)
+{
+    const __m128 a = _mm_loadu_ps(&p[0].x);
+    const __m128 b = _mm_loadu_ps(&p[2].x);
+    xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+#elif defined(IMNODES_SIMD_NEON)
+typedef float32x4_t simd_float;
+typedef uint32x4_t simd_mask;
+const int simd_width = 4;
+
+inline simd_float simd_set1(const float v) { return vdupq_n_f32(v); }
+inline simd_float simd_load(const float* const p) { return vld1q_f32(p); }
+inline void simd_store(float* const p, const simd_float v) { vst1q_f32(p, v); }
+inline simd_float simd_add(const simd_float a, const simd_float b) { return vaddq_f32(a, b); }
+inline simd_float simd_sub(const simd_float a, const simd_float b) { return vsubq_f32(a, b); }
+inline simd_float simd_mul(const simd_float a, const simd_float b) { return vmulq_f32(a, b); }
+inline simd_mask simd_cmplt(const simd_float a, const simd_float b) { return vcltq_f32(a, b); }
+inline simd_mask simd_cmpge(const simd_float a, const simd_float b) { return vcgeq_f32(a, b); }
+inline simd_mask simd_and(const simd_mask a, const simd_mask b) { return vandq_u32(a, b); }
+inline simd_mask simd_or(const simd_mask a, const simd_mask b) { return vorrq_u32(a, b); }
+inline simd_mask simd_xor(const simd_mask a, const simd_mask b) { return veorq_u32(a, b); }
+inline bool simd_any(const simd_mask m)
+{
+    const uint32x2_t halves = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1)) != 0u;
+}
+// Loads the x and y coordinates of simd_width consecutive points.
+inline void simd_load_points(const ImVec2* const p, simd_float& xs, simd_float& ys)
+{
+    const float32x4x2_t xy = vld2q_f32(&p[0].x);
+    xs = xy.val[0];
+    ys = xy.val[1];
+}
+#endif
+
+// Evaluates the curve at t = t_step * i, for i in [first, first + count).
+inline void eval_bezier_uniform(
+    const BezierCurve& bezier,
+    const float t_step,
+    const int first,
+    const int count,
+    ImVec2* const out)
 {
-    ImVec2 current = eval_bezier(0.f, link_data.bezier);
-    const float dt = 1.0f / link_data.num_segments;
-    for (int s = 0; s < link_data.num_segments; ++s)
+    int i = 0;
+#if defined(IMNODES_SIMD)
     {
-        ImVec2 next = eval_bezier(static_cast<float>((s + 1) * dt), link_data.bezier);
-        if (rectangle_overlaps_line_segment(rectangle, current, next))
+        float lanes[simd_width];
+        for (int lane = 0; lane < simd_width; ++lane)
         {
-            return true;
+            lanes[lane] = static_cast<float>(lane);
+        }
+        const simd_float lane_offsets = simd_load(lanes);
+        const simd_float one = simd_set1(1.f);
+        const simd_float three = simd_set1(3.f);
+        const simd_float step = simd_set1(t_step);
+        const simd_float p0x = simd_set1(bezier.p0.x), p0y = simd_set1(bezier.p0.y);
+        const simd_float p1x = simd_set1(bezier.p1.x), p1y = simd_set1(bezier.p1.y);
+        const simd_float p2x = simd_set1(bezier.p2.x), p2y = simd_set1(bezier.p2.y);
+        const simd_float p3x = simd_set1(bezier.p3.x), p3y = simd_set1(bezier.p3.y);
+
+        for (; i + simd_width <= count; i += simd_width)
+        {
+            const simd_float index =
+                simd_add(simd_set1(static_cast<float>(first + i)), lane_offsets);
+            const simd_float t = simd_mul(step, index);
+            const simd_float u = simd_sub(one, t);
+            const simd_float w0 = simd_mul(simd_mul(u, u), u);
+            const simd_float w1 = simd_mul(simd_mul(simd_mul(three, u), u), t);
+            const simd_float w2 = simd_mul(simd_mul(simd_mul(three, u), t), t);
+            const simd_float w3 = simd_mul(simd_mul(t, t), t);
+
+            float xs[simd_width], ys[simd_width];
+            simd_store(
+                xs,
+                simd_add(
+                    simd_add(
+                        simd_add(simd_mul(w0, p0x), simd_mul(w1, p1x)), simd_mul(w2, p2x)),
+                    simd_mul(w3, p3x)));
+            simd_store(
+                ys,
+                simd_add(
+                    simd_add(
+                        simd_add(simd_mul(w0, p0y), simd_mul(w1, p1y)), simd_mul(w2, p2y)),
+                    simd_mul(w3, p3y)));
+            for (int lane = 0; lane < simd_width; ++lane)
+            {
+                out[i + lane] = ImVec2(xs[lane], ys[lane]);
+            }
         }
-        current = next;
     }
-    return false;
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = eval_bezier(t_step * (first + i), bezier);
+    }
 }
 
-inline bool rectangle_overlaps_link(
-    const ImRect& rectangle,
-    const ImVec2& start,
-    const ImVec2& end,
-    const AttributeType start_type)
+// Evaluates the curve with precomputed Bernstein weights: out[i] = w0[i] p0 + w1[i] p1 + w2[i] p2 +
+// w3[i] p3.
+inline void eval_bezier_weighted(
+    const BezierCurve& bezier,
+    const float* const w0,
+    const float* const w1,
+    const float* const w2,
+    const float* const w3,
+    const int count,
+    ImVec2* const out)
 {
-    // First level: simple rejection test via rectangle overlap:
-
-    ImRect lrect = ImRect(start, end);
-    if (lrect.Min.x > lrect.Max.x)
+    int i = 0;
+#if defined(IMNODES_SIMD)
     {
-        ImSwap(lrect.Min.x, lrect.Max.x);
-    }
+        const simd_float p0x = simd_set1(bezier.p0.x), p0y = simd_set1(bezier.p0.y);
+        const simd_float p1x = simd_set1(bezier.p1.x), p1y = simd_set1(bezier.p1.y);
+        const simd_float p2x = simd_set1(bezier.p2.x), p2y = simd_set1(bezier.p2.y);
+        const simd_float p3x = simd_set1(bezier.p3.x), p3y = simd_set1(bezier.p3.y);
 
-    if (lrect.Min.y > lrect.Max.y)
+        for (; i + simd_width <= count; i += simd_width)
+        {
+            const simd_float b0 = simd_load(w0 + i);
+            const simd_float b1 = simd_load(w1 + i);
+            const simd_float b2 = simd_load(w2 + i);
+            const simd_float b3 = simd_load(w3 + i);
+
+            float xs[simd_width], ys[simd_width];
+            simd_store(
+                xs,
+                simd_add(
+                    simd_add(
+                        simd_add(simd_mul(b0, p0x), simd_mul(b1, p1x)), simd_mul(b2, p2x)),
+                    simd_mul(b3, p3x)));
+            simd_store(
+                ys,
+                simd_add(
+                    simd_add(
+                        simd_add(simd_mul(b0, p0y), simd_mul(b1, p1y)), simd_mul(b2, p2y)),
+                    simd_mul(b3, p3y)));
+            for (int lane = 0; lane < simd_width; ++lane)
+            {
+                out[i + lane] = ImVec2(xs[lane], ys[lane]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i)
     {
-        ImSwap(lrect.Min.y, lrect.Max.y);
+        out[i] = ImVec2(
+            w0[i] * bezier.p0.x + w1[i] * bezier.p1.x + w2[i] * bezier.p2.x + w3[i] * bezier.p3.x,
+            w0[i] * bezier.p0.y + w1[i] * bezier.p1.y + w2[i] * bezier.p2.y + w3[i] * bezier.p3.y);
     }
+}
 
-    if (rectangle.Overlaps(lrect))
+// Returns true if the rectangle overlaps any segment of the polyline, as tested by
+// rectangle_overlaps_line_segment(). The rectangle's min and max must be ordered.
+inline bool rectangle_overlaps_polyline(
+    const ImRect& rect,
+    const ImVec2* const points,
+    const int num_points)
+{
+    int i = 0;
+#if defined(IMNODES_SIMD)
     {
-        // First, check if either one or both endpoinds are trivially contained
-        // in the rectangle
+        const simd_float zero = simd_set1(0.f);
+        const simd_float min_x = simd_set1(rect.Min.x), min_y = simd_set1(rect.Min.y);
+        const simd_float max_x = simd_set1(rect.Max.x), max_y = simd_set1(rect.Max.y);
+        const simd_float corners_x[4] = {min_x, max_x, min_x, max_x};
+        const simd_float corners_y[4] = {min_y, min_y, max_y, max_y};
 
-        if (rectangle.Contains(start) || rectangle.Contains(end))
+        for (; i + simd_width < num_points; i += simd_width)
         {
-            return true;
-        }
+            simd_float x1, y1, x2, y2;
+            simd_load_points(points + i, x1, y1);
+            simd_load_points(points + i + 1, x2, y2);
+
+            // rect.Contains(p1) && rect.Contains(p2)
+            const simd_mask contains_both = simd_and(
+                simd_and(
+                    simd_and(simd_cmpge(x1, min_x), simd_cmpge(y1, min_y)),
+                    simd_and(simd_cmplt(x1, max_x), simd_cmplt(y1, max_y))),
+                simd_and(
+                    simd_and(simd_cmpge(x2, min_x), simd_cmpge(y2, min_y)),
+                    simd_and(simd_cmplt(x2, max_x), simd_cmplt(y2, max_y))));
+            if (simd_any(contains_both))
+            {
+                return true;
+            }
 
-        // Second level of refinement: do a more expensive test against the
-        // link
+            // Either endpoint strictly inside of the rectangle. Otherwise, the segment can't
+            // overlap, and the line test can be skipped. Most segments are far from the rectangle.
+            const simd_mask endpoint_inside = simd_or(
+                simd_and(
+                    simd_and(simd_cmplt(min_x, x1), simd_cmplt(x1, max_x)),
+                    simd_and(simd_cmplt(min_y, y1), simd_cmplt(y1, max_y))),
+                simd_and(
+                    simd_and(simd_cmplt(min_x, x2), simd_cmplt(x2, max_x)),
+                    simd_and(simd_cmplt(min_y, y2), simd_cmplt(y2, max_y))));
+            if (!simd_any(endpoint_inside))
+            {
+                continue;
+            }
 
-        const LinkBezierData link_data =
-            get_link_renderable(start, end, start_type, g.style.link_line_segments_per_length);
-        return rectangle_overlaps_bezier(rectangle, link_data);
-    }
+            // The signs of eval_implicit_line_eq() at the four corners, as positive and negative
+            // masks.
+            const simd_float a = simd_sub(y2, y1);
+            const simd_float b = simd_sub(x1, x2);
+            const simd_float c = simd_sub(simd_mul(x2, y1), simd_mul(x1, y2));
+            simd_mask positive[4], negative[4];
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                const simd_float v = simd_add(
+                    simd_add(simd_mul(a, corners_x[corner]), simd_mul(b, corners_y[corner])), c);
+                positive[corner] = simd_cmplt(zero, v);
+                negative[corner] = simd_cmplt(v, zero);
+            }
 
+            // The corner loop of rectangle_overlaps_line_segment() stops at the first zero sign,
+            // and finds an intersection at the first sign which differs from the previous one.
+            simd_mask line_intersects = simd_and(
+                simd_or(positive[3], negative[3]),
+                simd_or(
+                    simd_xor(positive[3], positive[2]), simd_xor(negative[3], negative[2])));
+            for (int corner = 2; corner >= 0; --corner)
+            {
+                const int prev = corner == 0 ? 3 : corner - 1;
+                line_intersects = simd_and(
+                    simd_or(positive[corner], negative[corner]),
+                    simd_or(
+                        simd_or(
+                            simd_xor(positive[corner], positive[prev]),
+                            simd_xor(negative[corner], negative[prev])),
+                        line_intersects));
+            }
+
+            if (simd_any(simd_and(line_intersects, endpoint_inside)))
+            {
+                return true;
+            }
+        }
+    }
+#endif
+    for (; i + 1 < num_points; ++i)
+    {
+        if (rectangle_overlaps_line_segment(rect, points[i], points[i + 1]))
+        {
+            return true;
+        }
+    }
     return false;
 }
+
+// Calculates the squared distance between p and each of the points.
+inline void get_squared_distances(
+    const ImVec2& p,
+    const ImVec2* const points,
+    const int count,
+    float* const out)
+{
+    int i = 0;
+#if defined(IMNODES_SIMD)
+    {
+        const simd_float px = simd_set1(p.x), py = simd_set1(p.y);
+        for (; i + simd_width <= count; i += simd_width)
+        {
+            simd_float xs, ys;
+            simd_load_points(points + i, xs, ys);
+            const simd_float dx = simd_sub(px, xs);
+            const simd_float dy = simd_sub(py, ys);
+            simd_store(out + i, simd_add(simd_mul(dx, dx), simd_mul(dy, dy)));
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        const ImVec2 delta = p - points[i];
+        out[i] = delta.x * delta.x + delta.y * delta.y;
+    }
+}
+
 } // namespace
 
-// [SECTION] editor context definition
+// [SECTION] context definition
 
-struct EditorContext
+// Holds all of the state which isn't specific to an editor: the style, the IO settings, and the
+// state of the frame being built, most of which only lives for one frame.
+struct Context
 {
-    ObjectPool<NodeData> nodes;
-    ObjectPool<PinData> pins;
-    ObjectPool<LinkData> links;
+    EditorContext* default_editor_ctx;
+    EditorContext* editor_ctx;
+    ImDrawList* canvas_draw_list;
+    ImVec2 canvas_origin_screen_space;
+    ImRect canvas_rect_screen_space;
+    ScopeFlags current_scope;
 
-    // ui related fields
-    ImVec2 panning;
+    IO io;
+    Style style;
+    ImVector<ColorStyleElement> color_modifier_stack;
+    ImVector<StyleElement> style_modifier_stack;
+    ImGuiTextBuffer text_buffer;
+    ImVector<char> binary_buffer;
+    // The INI load begun by BeginLoadEditorStateFromIni(), if any.
+    IniLoadState ini_load;
 
-    ImVector<int> selected_node_indices;
-    ImVector<int> selected_link_indices;
+    int current_attribute_flags;
+    ImVector<int> attribute_flag_stack;
 
-    ClickInteractionType click_interaction_type;
-    ClickInteractionState click_interaction_state;
+    int current_node_idx;
+    int current_node_channel;
+    int current_node_flags;
+    // Set when the current node's contents are submitted only to lay the node out, and are clipped
+    // away.
+    bool current_node_contents_hidden;
+    // The size of the canvas vertex buffer, and the next vertex index, when the current node was
+    // begun. Used to record the node's content snapshot.
+    int current_node_first_vertex;
+    unsigned int current_node_first_idx;
+
+    // The nodes submitted during the current frame, in submission order, and the draw list channel
+    // which each node's background is drawn into. The nodes are drawn in EndNodeEditor(), once the
+    // hovered elements are known.
+    ImVector<int> submitted_node_indices;
+    ImVector<int> submitted_node_channels;
+    // The number of channels the canvas draw list was split into by BeginNodeEditor(), the number
+    // of them in use, and the number the submitted nodes asked for.
+    int canvas_channel_count;
+    int canvas_channels_in_use;
+    int canvas_channels_requested;
+    // Node rectangles and pin positions of the submitted nodes, in screen space.
+    SpatialGrid node_grid;
+    SpatialGrid pin_grid;
+    // All pins within hover distance of the mouse cursor. g.hovered_pin_idx is the last of them.
+    ImVector<int> hovered_pin_indices;
+    // Pre-tessellated pin shapes, indexed by PinShape. Built in BeginNodeEditor() when
+    // pin_stamp_key changes.
+    PinStamp pin_stamps[PinShape_QuadFilled + 1];
+    PinStampKey pin_stamp_key;
+    bool pin_stamps_built;
+    // Bernstein weight tables for evaluating curves at t = i / num_segments. The tables are stored
+    // back to back. Each one holds the (1-t)**3, 3(1-t)**2 t, 3(1-t)t**2 and t**3 weights as four
+    // arrays of num_segments + 1 floats. The offsets are indexed by num_segments, and are -1 for
+    // the tables which weren't built yet.
+    ImVector<int> bernstein_table_offsets;
+    ImVector<float> bernstein_weights;
+
+    // Scratch space for the pin grid entries near the mouse cursor.
+    ImVector<int> pin_hover_candidates;
+    ImVector<ImVec2> pin_hover_positions;
+    ImVector<float> pin_hover_distances;
+    // The links whose rectangles contain the mouse cursor. Only these are tested for hovering.
+    IndexSelection link_hover_candidates;
+    // Scratch space for link BVH queries.
+    ImVector<int> link_query_results;
+    // Scratch space for the screen space points of the link being drawn.
+    ImVector<ImVec2> link_points;
+    // The links to be drawn this frame, when their geometry is built by jobs.
+    ImVector<LinkDrawItem> link_draw_items;
+    // The jobs which build link and node geometry when io.job_dispatch is set, and the geometry
+    // of each link or node which they built. The jobs are allocated on demand.
+    ImVector<DrawJob*> draw_jobs;
+    ImVector<DrawJobItem> draw_job_items;
+    // Scratch space for box selection: one bit per link pool slot for sorting the candidate links,
+    // and the nodes and candidate links which overlap the box.
+    ImVector<ImU32> link_index_bits;
+    ImVector<ImU32> selection_node_hits;
+    ImVector<ImU32> selection_link_hits;
+    int current_pin_idx;
+    int current_attribute_id;
 
-    EditorContext()
-        : nodes(), pins(), links(), panning(0.f, 0.f), selected_node_indices(),
-          selected_link_indices(), click_interaction_type(ClickInteractionType_None),
-          click_interaction_state()
+    OptionalIndex hovered_node_idx;
+    OptionalIndex hovered_link_idx;
+    OptionalIndex hovered_pin_idx;
+    int hovered_pin_flags;
+
+    OptionalIndex deleted_link_idx;
+    OptionalIndex snap_link_idx;
+
+    int element_state_change;
+
+    int active_attribute_id;
+    bool active_attribute;
+
+    bool left_mouse_clicked;
+    bool left_mouse_released;
+    bool middle_mouse_clicked;
+    bool left_mouse_dragging;
+    bool middle_mouse_dragging;
+
+    Context()
+        : default_editor_ctx(NULL), editor_ctx(NULL), canvas_draw_list(NULL),
+          canvas_origin_screen_space(0.f, 0.f),
+          canvas_rect_screen_space(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f)),
+          current_scope(Scope_None), io(), style(), color_modifier_stack(),
+          style_modifier_stack(), text_buffer(), binary_buffer(), ini_load(),
+          current_attribute_flags(AttributeFlags_None), attribute_flag_stack(),
+          current_node_idx(INT_MAX), current_node_channel(0),
+          current_node_flags(NodeFlags_None), current_node_contents_hidden(false),
+          current_node_first_vertex(0),
+          current_node_first_idx(0), submitted_node_indices(), submitted_node_channels(),
+          canvas_channel_count(1), canvas_channels_in_use(1), canvas_channels_requested(1),
+          node_grid(), pin_grid(), hovered_pin_indices(), pin_stamp_key(),
+          pin_stamps_built(false), bernstein_table_offsets(), bernstein_weights(),
+          pin_hover_candidates(), pin_hover_positions(), pin_hover_distances(),
+          link_hover_candidates(), link_query_results(), link_points(), link_draw_items(),
+          draw_jobs(), draw_job_items(), link_index_bits(), selection_node_hits(),
+          selection_link_hits(), current_pin_idx(INT_MAX),
+          current_attribute_id(0), hovered_node_idx(), hovered_link_idx(), hovered_pin_idx(),
+          hovered_pin_flags(AttributeFlags_None), deleted_link_idx(), snap_link_idx(),
+          element_state_change(ElementStateChange_None), active_attribute_id(0),
+          active_attribute(false), left_mouse_clicked(false), left_mouse_released(false),
+          middle_mouse_clicked(false), left_mouse_dragging(false), middle_mouse_dragging(false)
+    {
+    }
+
+    ~Context()
     {
+        for (int i = 0; i < draw_jobs.size(); ++i)
+        {
+            IM_DELETE(draw_jobs[i]);
+        }
     }
 };
 
 namespace
 {
-// [SECTION] ui state logic
+// The current context. See SetCurrentContext().
+IMNODES_THREAD_LOCAL Context* GImNodes = NULL;
 
-ImVec2 get_screen_space_pin_coordinates(
-    const ImRect& node_rect,
-    const ImRect& attribute_rect,
-    const AttributeType type)
+EditorContext& editor_context_get()
 {
-    assert(type == AttributeType_Input || type == AttributeType_Output);
-    const float x = type == AttributeType_Input ? (node_rect.Min.x - g.style.pin_offset)
-                                                : (node_rect.Max.x + g.style.pin_offset);
-    return ImVec2(x, 0.5f * (attribute_rect.Min.y + attribute_rect.Max.y));
+    Context& g = *GImNodes;
+    assert(g.editor_ctx != NULL);
+    return *g.editor_ctx;
 }
 
-ImVec2 get_screen_space_pin_coordinates(const EditorContext& editor, const PinData& pin)
+// Makes the context current on a job's thread for the duration of the job. GImNodes is only
+// written to if it differs, as it's shared with the main thread unless it's thread-local.
+struct JobContextScope
 {
-    const ImRect& parent_node_rect = editor.nodes.pool[pin.parent_node_idx].rect;
-    return get_screen_space_pin_coordinates(parent_node_rect, pin.attribute_rect, pin.type);
-}
+    Context* prev_ctx;
 
-// These functions are here, and not members of the BoxSelector struct, because
-// implementing a C API in C++ is frustrating. EditorContext has a BoxSelector
-// field, but the state changes depend on the editor. So, these are implemented
-// as C-style free functions so that the code is not too much of a mish-mash of
-// C functions and C++ method definitions.
+    JobContextScope(Context* const ctx) : prev_ctx(GImNodes)
+    {
+        if (GImNodes != ctx)
+        {
+            GImNodes = ctx;
+        }
+    }
+    ~JobContextScope()
+    {
+        if (GImNodes != prev_ctx)
+        {
+            GImNodes = prev_ctx;
+        }
+    }
+};
 
-void begin_node_selection(EditorContext& editor, const int node_idx)
+// Runs job(job_data, i) for each i in [0, job_count) with io.job_dispatch, or on the calling
+// thread if no dispatcher is set or there is only one job.
+void dispatch_jobs(const JobFunction job, void* const job_data, const int job_count)
 {
-    // Don't start selecting a node if we are e.g. already creating and dragging
-    // a new link! New link creation can happen when the mouse is clicked over
-    // a node, but within the hover radius of a pin.
-    if (editor.click_interaction_type != ClickInteractionType_None)
+    const IO::JobDispatch& job_dispatch = GImNodes->io.job_dispatch;
+    if (job_dispatch.dispatch != NULL && job_count > 1)
     {
+        job_dispatch.dispatch(job, job_data, job_count, job_dispatch.user_data);
         return;
     }
 
-    editor.click_interaction_type = ClickInteractionType_Node;
-    // If the node is not already contained in the selection, then we want only
-    // the interaction node to be selected, effective immediately.
-    //
-    // Otherwise, we want to allow for the possibility of multiple nodes to be
-    // moved at once.
-    if (!editor.selected_node_indices.contains(node_idx))
+    for (int i = 0; i < job_count; ++i)
     {
-        editor.selected_node_indices.clear();
-        editor.selected_link_indices.clear();
-        editor.selected_node_indices.push_back(node_idx);
+        job(job_data, i);
     }
 }
 
-void begin_link_selection(EditorContext& editor, const int link_idx)
+// Links longer than this many segments are rare enough to not be worth a table.
+const int max_bernstein_table_segments = 256;
+
+// Returns the Bernstein weight table for num_segments, or NULL if the segment count is too large
+// to be cached. The pointer is valid until the next call.
+const float* get_bernstein_table(const int num_segments)
 {
-    editor.click_interaction_type = ClickInteractionType_Link;
-    // When a link is selected, clear all other selections, and insert the link
-    // as the sole selection.
-    editor.selected_node_indices.clear();
-    editor.selected_link_indices.clear();
-    editor.selected_link_indices.push_back(link_idx);
-}
-
-void begin_link_detach(EditorContext& editor, const int link_idx, const int detach_pin_idx)
-{
-    const LinkData& link = editor.links.pool[link_idx];
-    ClickInteractionState& state = editor.click_interaction_state;
-    state.link_creation.end_pin_idx.reset();
-    state.link_creation.start_pin_idx =
-        detach_pin_idx == link.start_pin_idx ? link.end_pin_idx : link.start_pin_idx;
-    g.deleted_link_idx = link_idx;
-}
+    Context& g = *GImNodes;
+    if (num_segments > max_bernstein_table_segments)
+    {
+        return NULL;
+    }
 
-void begin_link_interaction(EditorContext& editor, const int link_idx)
-{
-    // First check if we are clicking a link in the vicinity of a pin.
-    // This may result in a link detach via click and drag.
-    if (editor.click_interaction_type == ClickInteractionType_LinkCreation)
+    if (g.bernstein_table_offsets.size() <= num_segments)
     {
-        if ((g.hovered_pin_flags & AttributeFlags_EnableLinkDetachWithDragClick) != 0)
+        const int old_size = g.bernstein_table_offsets.size();
+        g.bernstein_table_offsets.resize(num_segments + 1);
+        for (int i = old_size; i < g.bernstein_table_offsets.size(); ++i)
         {
-            begin_link_detach(editor, link_idx, g.hovered_pin_idx.value());
-            editor.click_interaction_state.link_creation.link_creation_type =
-                LinkCreationType_FromDetach;
+            g.bernstein_table_offsets[i] = -1;
         }
     }
-    // If we aren't near a pin, check if we are clicking the link with the
-    // modifier pressed. This may also result in a link detach via clicking.
-    else
-    {
-        const bool modifier_pressed = g.io.link_detach_with_modifier_click.modifier == NULL
-                                          ? false
-                                          : *g.io.link_detach_with_modifier_click.modifier;
-
-        if (modifier_pressed)
-        {
-            const LinkData& link = editor.links.pool[link_idx];
-            const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
-            const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
-            const ImVec2& mouse_pos = ImGui::GetIO().MousePos;
-            const float dist_to_start = ImLengthSqr(start_pin.pos - mouse_pos);
-            const float dist_to_end = ImLengthSqr(end_pin.pos - mouse_pos);
-            const int closest_pin_idx =
-                dist_to_start < dist_to_end ? link.start_pin_idx : link.end_pin_idx;
 
-            editor.click_interaction_type = ClickInteractionType_LinkCreation;
-            begin_link_detach(editor, link_idx, closest_pin_idx);
-        }
-        else
+    if (g.bernstein_table_offsets[num_segments] == -1)
+    {
+        const int offset = g.bernstein_weights.size();
+        const int count = num_segments + 1;
+        g.bernstein_table_offsets[num_segments] = offset;
+        g.bernstein_weights.resize(offset + 4 * count);
+
+        float* const weights = g.bernstein_weights.Data + offset;
+        // The weights are computed exactly like eval_bezier() computes them.
+        const float t_step = 1.0f / (float)num_segments;
+        for (int i = 0; i < count; ++i)
         {
-            begin_link_selection(editor, link_idx);
+            const float t = t_step * i;
+            weights[i] = (1 - t) * (1 - t) * (1 - t);
+            weights[count + i] = 3 * (1 - t) * (1 - t) * t;
+            weights[2 * count + i] = 3 * (1 - t) * t * t;
+            weights[3 * count + i] = t * t * t;
         }
     }
-}
 
-void begin_link_creation(EditorContext& editor, const int hovered_pin_idx)
-{
-    editor.click_interaction_type = ClickInteractionType_LinkCreation;
-    editor.click_interaction_state.link_creation.start_pin_idx = hovered_pin_idx;
-    editor.click_interaction_state.link_creation.end_pin_idx.reset();
-    editor.click_interaction_state.link_creation.link_creation_type = LinkCreationType_Standard;
-    g.element_state_change |= ElementStateChange_LinkStarted;
+    return g.bernstein_weights.Data + g.bernstein_table_offsets[num_segments];
 }
 
-void begin_canvas_interaction(EditorContext& editor)
+// Evaluates the curve at t = i / num_segments, for i in [first, first + count).
+void eval_bezier_segments(
+    const BezierCurve& bezier,
+    const int num_segments,
+    const int first,
+    const int count,
+    ImVec2* const out)
 {
-    const bool any_ui_element_hovered = g.hovered_node_idx.has_value() ||
-                                        g.hovered_link_idx.has_value() ||
-                                        g.hovered_pin_idx.has_value() || ImGui::IsAnyItemHovered();
-
-    const bool mouse_not_in_canvas =
-        !(g.canvas_rect_screen_space.Contains(ImGui::GetMousePos()) && ImGui::IsWindowHovered());
-
-    if (any_ui_element_hovered || mouse_not_in_canvas)
+    const float* const table = get_bernstein_table(num_segments);
+    if (table == NULL)
     {
+        eval_bezier_uniform(bezier, 1.0f / (float)num_segments, first, count, out);
         return;
     }
 
-    const bool started_panning =
-        g.io.emulate_three_button_mouse.enabled
-            ? (g.left_mouse_clicked && *g.io.emulate_three_button_mouse.modifier)
-            : g.middle_mouse_clicked;
-
-    editor.click_interaction_type =
-        started_panning ? ClickInteractionType_Panning : ClickInteractionType_BoxSelection;
-
-    if (editor.click_interaction_type == ClickInteractionType_BoxSelection)
-    {
-        editor.click_interaction_state.box_selector.rect.Min = ImGui::GetIO().MousePos;
-    }
+    const int stride = num_segments + 1;
+    eval_bezier_weighted(
+        bezier,
+        table + first,
+        table + stride + first,
+        table + 2 * stride + first,
+        table + 3 * stride + first,
+        count,
+        out);
 }
 
-void box_selector_update_selection(EditorContext& editor, ImRect box_rect)
+inline ImVec2 eval_bezier_derivative(float t, const BezierCurve& bezier)
 {
-    // Invert box selector coordinates as needed
+    // B'(t) = 3(1-t)**2 (P1 - P0) + 6(1-t)t (P2 - P1) + 3t**2 (P3 - P2)
+    return (bezier.p1 - bezier.p0) * (3 * (1 - t) * (1 - t)) +
+           (bezier.p2 - bezier.p1) * (6 * (1 - t) * t) + (bezier.p3 - bezier.p2) * (3 * t * t);
+}
 
-    if (box_rect.Min.x > box_rect.Max.x)
-    {
-        ImSwap(box_rect.Min.x, box_rect.Max.x);
-    }
+inline ImVec2 eval_bezier_second_derivative(float t, const BezierCurve& bezier)
+{
+    // B''(t) = 6(1-t) (P2 - 2P1 + P0) + 6t (P3 - 2P2 + P1)
+    return (bezier.p2 - bezier.p1 * 2 + bezier.p0) * (6 * (1 - t)) +
+           (bezier.p3 - bezier.p2 * 2 + bezier.p1) * (6 * t);
+}
 
-    if (box_rect.Min.y > box_rect.Max.y)
+// Finds the local minimum of the distance between the curve and p within [t_min, t_max]. The
+// distance derivative must be negative at t_min and non-negative at t_max. Newton's method on the
+// derivative is safeguarded by bisection, so the iteration stays within the shrinking bracket.
+// Once the iteration has converged, rounding noise in the derivative can still trigger bisection
+// steps away from the minimum, so the closest iterate is returned instead of the last one.
+float refine_closest_point_on_cubic_bezier(
+    const ImVec2& p,
+    const BezierCurve& bezier,
+    float t_min,
+    float t_max)
+{
+    float t = 0.5f * (t_min + t_max);
+    float t_closest = t;
+    float closest_dist = FLT_MAX;
+    const int num_iterations = 8;
+    for (int i = 0; i < num_iterations; ++i)
     {
-        ImSwap(box_rect.Min.y, box_rect.Max.y);
-    }
+        const ImVec2 to_curve = eval_bezier(t, bezier) - p;
+        const ImVec2 d1 = eval_bezier_derivative(t, bezier);
+        const ImVec2 d2 = eval_bezier_second_derivative(t, bezier);
+        const float f = ImDot(to_curve, d1);
+        const float df = ImDot(d1, d1) + ImDot(to_curve, d2);
+
+        const float dist = ImLengthSqr(to_curve);
+        if (dist < closest_dist)
+        {
+            t_closest = t;
+            closest_dist = dist;
+        }
 
-    // Update node selection
+        if (f < 0.f)
+        {
+            t_min = t;
+        }
+        else
+        {
+            t_max = t;
+        }
 
-    editor.selected_node_indices.clear();
+        float t_next = 0.5f * (t_min + t_max);
+        if (df > 0.f)
+        {
+            const float t_newton = t - f / df;
+            if (t_newton > t_min && t_newton < t_max)
+            {
+                t_next = t_newton;
+            }
+        }
+        t = t_next;
+    }
 
-    // Test for overlap against node rectangles
+    return t_closest;
+}
 
-    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+// Calculates the closest point on the curve. The curve and the distance derivative are sampled at
+// a fixed number of evenly spaced parameters. Each interval where the derivative changes sign from
+// negative to positive holds a local minimum, which is refined with Newton's method. The samples
+// themselves, which include the endpoints, are candidates as well. An interval can hide a pair of
+// sign changes, and the closest sample bounds the error in that case. The cost doesn't depend on
+// the length of the curve.
+ImVec2 get_closest_point_on_cubic_bezier(const ImVec2& p, const BezierCurve& bezier)
+{
+    // B'(t) is a quadratic curve. It is evaluated as the equivalent cubic curve, so that the
+    // samples of both curves come from the same kernel.
+    BezierCurve derivative;
+    derivative.p0 = (bezier.p1 - bezier.p0) * 3.f;
+    derivative.p1 = (bezier.p1 - bezier.p0) + (bezier.p2 - bezier.p1) * 2.f;
+    derivative.p2 = (bezier.p2 - bezier.p1) * 2.f + (bezier.p3 - bezier.p2);
+    derivative.p3 = (bezier.p3 - bezier.p2) * 3.f;
+
+    const int num_samples = 32;
+    const float t_step = 1.f / num_samples;
+    ImVec2 points[num_samples + 1];
+    ImVec2 tangents[num_samples + 1];
+    eval_bezier_segments(bezier, num_samples, 0, num_samples + 1, points);
+    eval_bezier_segments(derivative, num_samples, 0, num_samples + 1, tangents);
+
+    float t_closest = 0.f;
+    float p_closest_dist = ImLengthSqr(points[0] - p);
+    float f_prev = ImDot(points[0] - p, tangents[0]);
+    for (int i = 1; i <= num_samples; ++i)
     {
-        if (editor.nodes.in_use[node_idx])
+        const float t_next = t_step * i;
+        const float sample_dist = ImLengthSqr(points[i] - p);
+        if (sample_dist < p_closest_dist)
         {
-            NodeData& node = editor.nodes.pool[node_idx];
-            if (box_rect.Overlaps(node.rect))
+            t_closest = t_next;
+            p_closest_dist = sample_dist;
+        }
+
+        const float f = ImDot(points[i] - p, tangents[i]);
+        if (f_prev < 0.f && f >= 0.f)
+        {
+            const float t =
+                refine_closest_point_on_cubic_bezier(p, bezier, t_next - t_step, t_next);
+            const float dist = ImLengthSqr(eval_bezier(t, bezier) - p);
+            if (dist < p_closest_dist)
             {
-                editor.selected_node_indices.push_back(node_idx);
+                t_closest = t;
+                p_closest_dist = dist;
             }
         }
+        f_prev = f;
     }
 
-    // Update link selection
+    return eval_bezier(t_closest, bezier);
+}
 
-    editor.selected_link_indices.clear();
+inline float get_distance_to_cubic_bezier(const ImVec2& pos, const BezierCurve& bezier)
+{
+    const ImVec2 point_on_curve = get_closest_point_on_cubic_bezier(pos, bezier);
 
-    // Test for overlap against links
+    const ImVec2 to_curve = point_on_curve - pos;
+    return ImSqrt(ImLengthSqr(to_curve));
+}
 
-    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
-    {
-        if (editor.links.in_use[link_idx])
-        {
-            const LinkData& link = editor.links.pool[link_idx];
+inline ImRect get_containing_rect_for_bezier_curve(const BezierCurve& bezier)
+{
+    Context& g = *GImNodes;
+    const ImVec2 min = ImVec2(ImMin(bezier.p0.x, bezier.p3.x), ImMin(bezier.p0.y, bezier.p3.y));
+    const ImVec2 max = ImVec2(ImMax(bezier.p0.x, bezier.p3.x), ImMax(bezier.p0.y, bezier.p3.y));
 
-            const PinData& pin_start = editor.pins.pool[link.start_pin_idx];
-            const PinData& pin_end = editor.pins.pool[link.end_pin_idx];
-            const ImRect& node_start_rect = editor.nodes.pool[pin_start.parent_node_idx].rect;
-            const ImRect& node_end_rect = editor.nodes.pool[pin_end.parent_node_idx].rect;
+    const float hover_distance = g.style.link_hover_distance;
 
-            const ImVec2 start = get_screen_space_pin_coordinates(
-                node_start_rect, pin_start.attribute_rect, pin_start.type);
-            const ImVec2 end = get_screen_space_pin_coordinates(
-                node_end_rect, pin_end.attribute_rect, pin_end.type);
+    ImRect rect(min, max);
+    rect.Add(bezier.p1);
+    rect.Add(bezier.p2);
+    rect.Expand(ImVec2(hover_distance, hover_distance));
 
-            // Test
-            if (rectangle_overlaps_link(box_rect, start, end, pin_start.type))
-            {
-                editor.selected_link_indices.push_back(link_idx);
-            }
-        }
-    }
+    return rect;
 }
 
-void translate_selected_nodes(EditorContext& editor)
+inline LinkBezierData get_link_renderable(
+    ImVec2 start,
+    ImVec2 end,
+    const AttributeType start_type,
+    const float line_segments_per_length)
 {
-    if (g.left_mouse_dragging)
+    assert((start_type == AttributeType_Input) || (start_type == AttributeType_Output));
+    if (start_type == AttributeType_Input)
     {
-        const ImGuiIO& io = ImGui::GetIO();
-        for (int i = 0; i < editor.selected_node_indices.size(); ++i)
-        {
-            const int node_idx = editor.selected_node_indices[i];
-            NodeData& node = editor.nodes.pool[node_idx];
-            if (node.draggable)
-            {
-                node.origin += io.MouseDelta;
-            }
-        }
+        ImSwap(start, end);
     }
+
+    const float link_length = ImSqrt(ImLengthSqr(end - start));
+    const ImVec2 offset = ImVec2(0.25f * link_length, 0.f);
+    LinkBezierData link_data;
+    link_data.bezier.p0 = start;
+    link_data.bezier.p1 = start + offset;
+    link_data.bezier.p2 = end - offset;
+    link_data.bezier.p3 = end;
+    link_data.num_segments = ImMax(static_cast<int>(link_length * line_segments_per_length), 1);
+    return link_data;
 }
 
-bool finish_link_at_hovered_pin(EditorContext& editor, const OptionalIndex maybe_hovered_pin_idx)
+// Subdivides the curve at its midpoint until the control points are within the tolerance of the
+// chord. The start point is not emitted.
+void flatten_bezier_adaptive(
+    const BezierCurve& bezier,
+    const float tolerance,
+    const int level,
+    ImVector<ImVec2>& points)
 {
-    if (!maybe_hovered_pin_idx.has_value())
+    // The largest distance between the curve and its chord is bounded by
+    // sqrt(max(ux, vx) + max(uy, vy)) / 4.
+    float ux = 3.f * bezier.p1.x - 2.f * bezier.p0.x - bezier.p3.x;
+    float uy = 3.f * bezier.p1.y - 2.f * bezier.p0.y - bezier.p3.y;
+    float vx = 3.f * bezier.p2.x - 2.f * bezier.p3.x - bezier.p0.x;
+    float vy = 3.f * bezier.p2.y - 2.f * bezier.p3.y - bezier.p0.y;
+    ux *= ux;
+    uy *= uy;
+    vx *= vx;
+    vy *= vy;
+
+    const int max_level = 10;
+    if (ImMax(ux, vx) + ImMax(uy, vy) <= 16.f * tolerance * tolerance || level >= max_level)
     {
-        g.element_state_change |= ElementStateChange_LinkDropped;
-        return false;
+        points.push_back(bezier.p3);
+        return;
     }
 
-    if (maybe_hovered_pin_idx == editor.click_interaction_state.link_creation.start_pin_idx)
+    const ImVec2 p01 = (bezier.p0 + bezier.p1) * 0.5f;
+    const ImVec2 p12 = (bezier.p1 + bezier.p2) * 0.5f;
+    const ImVec2 p23 = (bezier.p2 + bezier.p3) * 0.5f;
+    const ImVec2 p012 = (p01 + p12) * 0.5f;
+    const ImVec2 p123 = (p12 + p23) * 0.5f;
+    const ImVec2 p0123 = (p012 + p123) * 0.5f;
+
+    BezierCurve half;
+    half.p0 = bezier.p0;
+    half.p1 = p01;
+    half.p2 = p012;
+    half.p3 = p0123;
+    flatten_bezier_adaptive(half, tolerance, level + 1, points);
+
+    half.p0 = p0123;
+    half.p1 = p123;
+    half.p2 = p23;
+    half.p3 = bezier.p3;
+    flatten_bezier_adaptive(half, tolerance, level + 1, points);
+}
+
+// Replaces the points with the polyline which the link is drawn with. The flattening mode is set
+// by StyleFlags_AdaptiveLinkFlattening.
+void flatten_link(const LinkBezierData& link_data, ImVector<ImVec2>& points)
+{
+    Context& g = *GImNodes;
+    points.resize(0);
+    points.push_back(link_data.bezier.p0);
+
+    if ((g.style.flags & StyleFlags_AdaptiveLinkFlattening) != 0)
     {
-        return false;
+        flatten_bezier_adaptive(
+            link_data.bezier, ImMax(g.style.link_flattening_tolerance, 0.01f), 0, points);
+        return;
     }
 
-    const int end_pin_idx = maybe_hovered_pin_idx.value();
+    points.resize(link_data.num_segments + 1);
+    eval_bezier_segments(
+        link_data.bezier, link_data.num_segments, 1, link_data.num_segments, points.Data + 1);
+}
 
-    LinkData test_link;
-    test_link.start_pin_idx = editor.click_interaction_state.link_creation.start_pin_idx;
-    test_link.end_pin_idx = end_pin_idx;
-    if (editor.links.contains(test_link, LinkPredicate()))
+// The mouse position, the curve and the link rectangle are all in grid space.
+inline bool is_mouse_hovering_near_link(
+    const ImVec2& mouse_pos,
+    const LinkCurve& curve,
+    const ImRect& link_rect)
+{
+    Context& g = *GImNodes;
+    // First, do a simple bounding box test against the box containing the link
+    // to see whether calculating the distance to the link is worth doing.
+    if (link_rect.Contains(mouse_pos))
     {
-        return false;
+        const float distance = get_distance_to_cubic_bezier(mouse_pos, curve.bezier);
+        if (distance < g.style.link_hover_distance)
+        {
+            return true;
+        }
     }
 
-    editor.click_interaction_state.link_creation.end_pin_idx = end_pin_idx;
-
-    return true;
+    return false;
 }
 
-void click_interaction_update(EditorContext& editor)
+inline bool rectangle_overlaps_link_curve(const ImRect& rectangle, const LinkCurve& curve)
 {
-    switch (editor.click_interaction_type)
-    {
-    case ClickInteractionType_BoxSelection:
-    {
-        ImRect& box_rect = editor.click_interaction_state.box_selector.rect;
-        box_rect.Max = ImGui::GetIO().MousePos;
+    return rectangle_overlaps_polyline(rectangle, curve.points.Data, curve.points.size());
+}
 
-        box_selector_update_selection(editor, box_rect);
+// The rectangle and the curve are in grid space.
+inline bool rectangle_overlaps_link(const ImRect& rectangle, const LinkCurve& curve)
+{
+    const ImVec2& start = curve.start;
+    const ImVec2& end = curve.end;
 
-        const ImU32 box_selector_color = g.style.colors[ColorStyle_BoxSelector];
-        const ImU32 box_selector_outline = g.style.colors[ColorStyle_BoxSelectorOutline];
-        g.canvas_draw_list->AddRectFilled(box_rect.Min, box_rect.Max, box_selector_color);
-        g.canvas_draw_list->AddRect(box_rect.Min, box_rect.Max, box_selector_outline);
+    // First level: simple rejection test via rectangle overlap:
 
-        if (g.left_mouse_released)
-        {
-            editor.click_interaction_type = ClickInteractionType_None;
-        }
-    }
-    break;
-    case ClickInteractionType_Node:
+    ImRect lrect = ImRect(start, end);
+    if (lrect.Min.x > lrect.Max.x)
     {
-        translate_selected_nodes(editor);
+        ImSwap(lrect.Min.x, lrect.Max.x);
+    }
 
-        if (g.left_mouse_released)
-        {
-            editor.click_interaction_type = ClickInteractionType_None;
-        }
+    if (lrect.Min.y > lrect.Max.y)
+    {
+        ImSwap(lrect.Min.y, lrect.Max.y);
     }
-    break;
-    case ClickInteractionType_Link:
+
+    if (rectangle.Overlaps(lrect))
     {
-        if (g.left_mouse_released)
+        // First, check if either one or both endpoinds are trivially contained
+        // in the rectangle
+
+        if (rectangle.Contains(start) || rectangle.Contains(end))
         {
-            editor.click_interaction_type = ClickInteractionType_None;
+            return true;
         }
-    }
-    break;
-    case ClickInteractionType_LinkCreation:
-    {
-        const PinData& pin =
-            editor.pins.pool[editor.click_interaction_state.link_creation.start_pin_idx];
 
-        const ImVec2 start_pos = get_screen_space_pin_coordinates(editor, pin);
+        // Second level of refinement: do a more expensive test against the
+        // link
 
-        const bool should_snap = g.hovered_pin_idx.has_value() &&
-                                 editor.pins.pool[g.hovered_pin_idx.value()].type != pin.type;
+        return rectangle_overlaps_link_curve(rectangle, curve);
+    }
 
-        const bool snapping_pin_changed =
-            !(g.hovered_pin_idx == editor.click_interaction_state.link_creation.end_pin_idx);
+    return false;
+}
+} // namespace
 
-        // Detach the link that was created by this link event if it's no longer in snap range
+// [SECTION] editor context definition
+
+struct EditorContext
+{
+    ObjectPool<NodeData> nodes;
+    ObjectPool<PinData> pins;
+    ObjectPool<LinkData> links;
+
+    // ui related fields
+    ImVec2 panning;
+
+    // Maps the pin pairs of the links submitted during the current frame to the link indices.
+    IndexMap<ImU64> link_pin_pairs;
+    // The rectangles of the links submitted during the current frame. Updated in EndNodeEditor().
+    LinkBvh link_bvh;
+    // The cell size of the node hover grid, measured from the nodes submitted during the previous
+    // frame.
+    float node_grid_cell_size;
+    // The number of canvas draw list channels the nodes asked for during the previous frame, or 0
+    // before the editor's first frame.
+    int num_node_channels;
+
+    IndexSelection selected_node_indices;
+    IndexSelection selected_link_indices;
+
+    ClickInteractionType click_interaction_type;
+    ClickInteractionState click_interaction_state;
+
+    EditorContext()
+        : nodes(), pins(), links(), panning(0.f, 0.f), link_pin_pairs(), link_bvh(),
+          node_grid_cell_size(default_node_grid_cell_size), num_node_channels(0),
+          selected_node_indices(),
+          selected_link_indices(),
+          click_interaction_type(ClickInteractionType_None), click_interaction_state()
+    {
+    }
+};
+
+namespace
+{
+// [SECTION] ui state logic
+
+ImVec2 get_screen_space_pin_coordinates(
+    const ImRect& node_rect,
+    const ImRect& attribute_rect,
+    const AttributeType type)
+{
+    Context& g = *GImNodes;
+    assert(type == AttributeType_Input || type == AttributeType_Output);
+    const float x = type == AttributeType_Input ? (node_rect.Min.x - g.style.pin_offset)
+                                                : (node_rect.Max.x + g.style.pin_offset);
+    return ImVec2(x, 0.5f * (attribute_rect.Min.y + attribute_rect.Max.y));
+}
+
+ImVec2 get_screen_space_pin_coordinates(const EditorContext& editor, const PinData& pin)
+{
+    const ImRect& parent_node_rect = editor.nodes.pool[pin.parent_node_idx].rect;
+    return get_screen_space_pin_coordinates(parent_node_rect, pin.attribute_rect, pin.type);
+}
+
+// A node which has been submitted at least once has a valid rectangle.
+inline bool node_has_layout(const NodeData& node) { return node.rect.GetWidth() > 0.f; }
+
+// Moves the node's screen-space layout from the previous frame by the given delta, without
+// submitting the node's contents.
+void translate_node_layout(EditorContext& editor, NodeData& node, const ImVec2& delta)
+{
+    node.rect.Translate(delta);
+    node.title_bar_content_rect.Translate(delta);
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        PinData& pin = editor.pins.pool[node.pin_indices[i]];
+        pin.attribute_rect.Translate(delta);
+    }
+}
+
+// The canvas isn't scaled, so the size of a node on the screen is the size of its layout.
+NodeLod get_node_lod(const NodeData& node)
+{
+    Context& g = *GImNodes;
+    const float size = ImMin(node.rect.GetWidth(), node.rect.GetHeight());
+    if (size < g.style.node_lod_rect_size)
+    {
+        return NodeLod_Rect;
+    }
+    if (size < g.style.node_lod_chrome_size)
+    {
+        return NodeLod_Chrome;
+    }
+    return NodeLod_Full;
+}
+
+bool is_node_visible(const NodeData& node)
+{
+    Context& g = *GImNodes;
+    // The pins are rendered outside of the node rectangle, and can be hovered over from a
+    // distance.
+    const float pin_margin = ImFabs(g.style.pin_offset) + g.style.pin_hover_radius;
+    ImRect rect = node.rect;
+    rect.Expand(ImVec2(pin_margin, g.style.pin_hover_radius));
+    return g.canvas_rect_screen_space.Overlaps(rect);
+}
+
+// Keeps a culled node's pins alive for the current frame. The pin positions are calculated from the
+// node's previous layout, so that links to the culled node are still rendered in the right place.
+void cull_node(EditorContext& editor, const int node_idx)
+{
+    NodeData& node = editor.nodes.pool[node_idx];
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        const int pin_idx = node.pin_indices[i];
+        editor.pins.mark_in_use(pin_idx);
+        PinData& pin = editor.pins.pool[pin_idx];
+        pin.pos = get_screen_space_pin_coordinates(node.rect, pin.attribute_rect, pin.type);
+    }
+}
+
+// These functions are here, and not members of the BoxSelector struct, because
+// implementing a C API in C++ is frustrating. EditorContext has a BoxSelector
+// field, but the state changes depend on the editor. So, these are implemented
+// as C-style free functions so that the code is not too much of a mish-mash of
+// C functions and C++ method definitions.
+
+void begin_node_selection(EditorContext& editor, const int node_idx)
+{
+    // Don't start selecting a node if we are e.g. already creating and dragging
+    // a new link! New link creation can happen when the mouse is clicked over
+    // a node, but within the hover radius of a pin.
+    if (editor.click_interaction_type != ClickInteractionType_None)
+    {
+        return;
+    }
+
+    editor.click_interaction_type = ClickInteractionType_Node;
+    // If the node is not already contained in the selection, then we want only
+    // the interaction node to be selected, effective immediately.
+    //
+    // Otherwise, we want to allow for the possibility of multiple nodes to be
+    // moved at once.
+    if (!editor.selected_node_indices.contains(node_idx))
+    {
+        editor.selected_node_indices.clear();
+        editor.selected_link_indices.clear();
+        editor.selected_node_indices.push_back(node_idx);
+    }
+}
+
+void begin_link_selection(EditorContext& editor, const int link_idx)
+{
+    editor.click_interaction_type = ClickInteractionType_Link;
+    // When a link is selected, clear all other selections, and insert the link
+    // as the sole selection.
+    editor.selected_node_indices.clear();
+    editor.selected_link_indices.clear();
+    editor.selected_link_indices.push_back(link_idx);
+}
+
+void begin_link_detach(EditorContext& editor, const int link_idx, const int detach_pin_idx)
+{
+    Context& g = *GImNodes;
+    const LinkData& link = editor.links.pool[link_idx];
+    ClickInteractionState& state = editor.click_interaction_state;
+    state.link_creation.end_pin_idx.reset();
+    state.link_creation.start_pin_idx =
+        detach_pin_idx == link.start_pin_idx ? link.end_pin_idx : link.start_pin_idx;
+    g.deleted_link_idx = link_idx;
+}
+
+void begin_link_interaction(EditorContext& editor, const int link_idx)
+{
+    Context& g = *GImNodes;
+    // First check if we are clicking a link in the vicinity of a pin.
+    // This may result in a link detach via click and drag.
+    if (editor.click_interaction_type == ClickInteractionType_LinkCreation)
+    {
+        if ((g.hovered_pin_flags & AttributeFlags_EnableLinkDetachWithDragClick) != 0)
+        {
+            begin_link_detach(editor, link_idx, g.hovered_pin_idx.value());
+            editor.click_interaction_state.link_creation.link_creation_type =
+                LinkCreationType_FromDetach;
+        }
+    }
+    // If we aren't near a pin, check if we are clicking the link with the
+    // modifier pressed. This may also result in a link detach via clicking.
+    else
+    {
+        const bool modifier_pressed = g.io.link_detach_with_modifier_click.modifier == NULL
+                                          ? false
+                                          : *g.io.link_detach_with_modifier_click.modifier;
+
+        if (modifier_pressed)
+        {
+            const LinkData& link = editor.links.pool[link_idx];
+            const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
+            const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
+            const ImVec2& mouse_pos = ImGui::GetIO().MousePos;
+            const float dist_to_start = ImLengthSqr(start_pin.pos - mouse_pos);
+            const float dist_to_end = ImLengthSqr(end_pin.pos - mouse_pos);
+            const int closest_pin_idx =
+                dist_to_start < dist_to_end ? link.start_pin_idx : link.end_pin_idx;
+
+            editor.click_interaction_type = ClickInteractionType_LinkCreation;
+            begin_link_detach(editor, link_idx, closest_pin_idx);
+        }
+        else
+        {
+            begin_link_selection(editor, link_idx);
+        }
+    }
+}
+
+void begin_link_creation(EditorContext& editor, const int hovered_pin_idx)
+{
+    Context& g = *GImNodes;
+    editor.click_interaction_type = ClickInteractionType_LinkCreation;
+    editor.click_interaction_state.link_creation.start_pin_idx = hovered_pin_idx;
+    editor.click_interaction_state.link_creation.end_pin_idx.reset();
+    editor.click_interaction_state.link_creation.link_creation_type = LinkCreationType_Standard;
+    g.element_state_change |= ElementStateChange_LinkStarted;
+}
+
+void begin_canvas_interaction(EditorContext& editor)
+{
+    Context& g = *GImNodes;
+    const bool any_ui_element_hovered = g.hovered_node_idx.has_value() ||
+                                        g.hovered_link_idx.has_value() ||
+                                        g.hovered_pin_idx.has_value() || ImGui::IsAnyItemHovered();
+
+    const bool mouse_not_in_canvas =
+        !(g.canvas_rect_screen_space.Contains(ImGui::GetMousePos()) && ImGui::IsWindowHovered());
+
+    if (any_ui_element_hovered || mouse_not_in_canvas)
+    {
+        return;
+    }
+
+    const bool started_panning =
+        g.io.emulate_three_button_mouse.enabled
+            ? (g.left_mouse_clicked && *g.io.emulate_three_button_mouse.modifier)
+            : g.middle_mouse_clicked;
+
+    editor.click_interaction_type =
+        started_panning ? ClickInteractionType_Panning : ClickInteractionType_BoxSelection;
+
+    if (editor.click_interaction_type == ClickInteractionType_BoxSelection)
+    {
+        editor.click_interaction_state.box_selector.rect.Min = ImGui::GetIO().MousePos;
+    }
+}
+
+// Sorts distinct pool indices into ascending order. The bits are scratch space with one bit per
+// pool slot.
+void sort_pool_indices(ImVector<int>& indices, const int pool_size, ImVector<ImU32>& bits)
+{
+    bits.resize((pool_size + 31) >> 5);
+    memset(bits.Data, 0, sizeof(ImU32) * bits.size());
+    for (int i = 0; i < indices.size(); ++i)
+    {
+        ImBitArraySetBit(bits.Data, indices[i]);
+    }
+
+    int count = 0;
+    for (int index = bit_vector_next_set(bits, -1); index != -1;
+         index = bit_vector_next_set(bits, index))
+    {
+        indices[count++] = index;
+    }
+    assert(count == indices.size());
+}
+
+// The number of nodes, and of link candidates, which each box selection job tests. These are
+// multiples of 32, so that each job writes whole words of the hit bit vectors.
+const int nodes_per_selection_job = 4096;
+const int links_per_selection_job = 512;
+
+// Describes the box selection jobs of a frame. The first node_job_count jobs test ranges of the
+// node pool, and the rest test ranges of the link candidates. Bit i of node_hits is set if node i
+// overlaps the box, and bit i of link_hits is set if link_candidates[i] does.
+struct BoxSelectionBatch
+{
+    const EditorContext* editor;
+    ImRect box_rect;
+    ImRect grid_space_box_rect;
+    const int* link_candidates;
+    int link_candidate_count;
+    int node_job_count;
+    ImU32* node_hits;
+    ImU32* link_hits;
+};
+
+void run_box_selection_job(void* const job_data, const int job_index)
+{
+    const BoxSelectionBatch& batch = *static_cast<const BoxSelectionBatch*>(job_data);
+    if (job_index < batch.node_job_count)
+    {
+        const ObjectPool<NodeData>& nodes = batch.editor->nodes;
+        const int words_per_job = nodes_per_selection_job >> 5;
+        const int first_word = job_index * words_per_job;
+        const int last_word = ImMin(first_word + words_per_job, nodes.in_use.size());
+        for (int word = first_word; word < last_word; ++word)
+        {
+            ImU32 hits = 0u;
+            for (ImU32 in_use = nodes.in_use[word]; in_use != 0u; in_use &= in_use - 1u)
+            {
+                const int bit = count_trailing_zeros(in_use);
+                if (batch.box_rect.Overlaps(nodes.pool[(word << 5) + bit].rect))
+                {
+                    hits |= 1u << bit;
+                }
+            }
+            batch.node_hits[word] = hits;
+        }
+        return;
+    }
+
+    const ObjectPool<LinkData>& links = batch.editor->links;
+    const int first = (job_index - batch.node_job_count) * links_per_selection_job;
+    const int last = ImMin(first + links_per_selection_job, batch.link_candidate_count);
+    for (int i = first; i < last; i += 32)
+    {
+        ImU32 hits = 0u;
+        for (int bit = 0; bit < 32 && i + bit < last; ++bit)
+        {
+            const LinkData& link = links.pool[batch.link_candidates[i + bit]];
+            if (rectangle_overlaps_link(batch.grid_space_box_rect, link.curve))
+            {
+                hits |= 1u << bit;
+            }
+        }
+        batch.link_hits[i >> 5] = hits;
+    }
+}
+
+void box_selector_update_selection(EditorContext& editor, ImRect box_rect)
+{
+    Context& g = *GImNodes;
+    // Invert box selector coordinates as needed
+
+    if (box_rect.Min.x > box_rect.Max.x)
+    {
+        ImSwap(box_rect.Min.x, box_rect.Max.x);
+    }
+
+    if (box_rect.Min.y > box_rect.Max.y)
+    {
+        ImSwap(box_rect.Min.y, box_rect.Max.y);
+    }
+
+    // Only the links whose rectangles overlap the box are tested. The candidates are sorted, so
+    // that the links are selected in the same order as the links in the pool.
+
+    ImVector<int>& candidates = g.link_query_results;
+    candidates.resize(0);
+    const ImVec2 grid_space_origin = g.canvas_origin_screen_space + editor.panning;
+    const ImRect grid_space_box_rect(
+        box_rect.Min - grid_space_origin, box_rect.Max - grid_space_origin);
+    editor.link_bvh.query(grid_space_box_rect, candidates);
+    sort_pool_indices(candidates, editor.links.pool.size(), g.link_index_bits);
+
+    // Test for overlap against the node rectangles and the candidate links. The ranges of nodes
+    // and links may be tested concurrently, and the hits are then collected in index order.
+
+    g.selection_node_hits.resize(editor.nodes.in_use.size());
+    g.selection_link_hits.resize((candidates.size() + 31) >> 5);
+    const int node_job_count =
+        (editor.nodes.pool.size() + nodes_per_selection_job - 1) / nodes_per_selection_job;
+    const int link_job_count =
+        (candidates.size() + links_per_selection_job - 1) / links_per_selection_job;
+
+    BoxSelectionBatch batch = {
+        &editor,
+        box_rect,
+        grid_space_box_rect,
+        candidates.Data,
+        candidates.size(),
+        node_job_count,
+        g.selection_node_hits.Data,
+        g.selection_link_hits.Data};
+    dispatch_jobs(run_box_selection_job, &batch, node_job_count + link_job_count);
+
+    editor.selected_node_indices.clear();
+    for (int node_idx = bit_vector_next_set(g.selection_node_hits, -1); node_idx != -1;
+         node_idx = bit_vector_next_set(g.selection_node_hits, node_idx))
+    {
+        editor.selected_node_indices.push_back(node_idx);
+    }
+
+    editor.selected_link_indices.clear();
+    for (int i = bit_vector_next_set(g.selection_link_hits, -1); i != -1;
+         i = bit_vector_next_set(g.selection_link_hits, i))
+    {
+        editor.selected_link_indices.push_back(candidates[i]);
+    }
+}
+
+void translate_selected_nodes(EditorContext& editor)
+{
+    Context& g = *GImNodes;
+    if (g.left_mouse_dragging)
+    {
+        const ImGuiIO& io = ImGui::GetIO();
+        for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+        {
+            const int node_idx = editor.selected_node_indices[i];
+            NodeData& node = editor.nodes.pool[node_idx];
+            if (node.draggable)
+            {
+                node.origin += io.MouseDelta;
+            }
+        }
+    }
+}
+
+bool finish_link_at_hovered_pin(EditorContext& editor, const OptionalIndex maybe_hovered_pin_idx)
+{
+    Context& g = *GImNodes;
+    if (!maybe_hovered_pin_idx.has_value())
+    {
+        g.element_state_change |= ElementStateChange_LinkDropped;
+        return false;
+    }
+
+    if (maybe_hovered_pin_idx == editor.click_interaction_state.link_creation.start_pin_idx)
+    {
+        return false;
+    }
+
+    const int end_pin_idx = maybe_hovered_pin_idx.value();
+
+    const ImU64 pin_pair =
+        make_pin_pair_key(editor.click_interaction_state.link_creation.start_pin_idx, end_pin_idx);
+    if (editor.link_pin_pairs.find(pin_pair) != -1)
+    {
+        return false;
+    }
+
+    editor.click_interaction_state.link_creation.end_pin_idx = end_pin_idx;
+
+    return true;
+}
+
+void click_interaction_update(EditorContext& editor)
+{
+    Context& g = *GImNodes;
+    switch (editor.click_interaction_type)
+    {
+    case ClickInteractionType_BoxSelection:
+    {
+        ImRect& box_rect = editor.click_interaction_state.box_selector.rect;
+        box_rect.Max = ImGui::GetIO().MousePos;
+
+        box_selector_update_selection(editor, box_rect);
+
+        const ImU32 box_selector_color = g.style.colors[ColorStyle_BoxSelector];
+        const ImU32 box_selector_outline = g.style.colors[ColorStyle_BoxSelectorOutline];
+        g.canvas_draw_list->AddRectFilled(box_rect.Min, box_rect.Max, box_selector_color);
+        g.canvas_draw_list->AddRect(box_rect.Min, box_rect.Max, box_selector_outline);
+
+        if (g.left_mouse_released)
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
+    case ClickInteractionType_Node:
+    {
+        translate_selected_nodes(editor);
+
+        if (g.left_mouse_released)
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
+    case ClickInteractionType_Link:
+    {
+        if (g.left_mouse_released)
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
+    case ClickInteractionType_LinkCreation:
+    {
+        const PinData& pin =
+            editor.pins.pool[editor.click_interaction_state.link_creation.start_pin_idx];
+
+        const ImVec2 start_pos = get_screen_space_pin_coordinates(editor, pin);
+
+        const bool should_snap = g.hovered_pin_idx.has_value() &&
+                                 editor.pins.pool[g.hovered_pin_idx.value()].type != pin.type;
+
+        const bool snapping_pin_changed =
+            !(g.hovered_pin_idx == editor.click_interaction_state.link_creation.end_pin_idx);
+
+        // Detach the link that was created by this link event if it's no longer in snap range
         if (snapping_pin_changed && g.snap_link_idx.has_value())
         {
-            begin_link_detach(
-                editor,
-                g.snap_link_idx.value(),
-                editor.click_interaction_state.link_creation.end_pin_idx.value());
+            begin_link_detach(
+                editor,
+                g.snap_link_idx.value(),
+                editor.click_interaction_state.link_creation.end_pin_idx.value());
+        }
+
+        // If we are within the hover radius of a receiving pin, snap the link
+        // endpoint to it
+        const ImVec2 end_pos = should_snap
+                                   ? get_screen_space_pin_coordinates(
+                                         editor, editor.pins.pool[g.hovered_pin_idx.value()])
+                                   : ImGui::GetIO().MousePos;
+
+        const LinkBezierData link_data = get_link_renderable(
+            start_pos, end_pos, pin.type, g.style.link_line_segments_per_length);
+        flatten_link(link_data, g.link_points);
+        g.canvas_draw_list->AddPolyline(
+            g.link_points.Data,
+            g.link_points.size(),
+            g.style.colors[ColorStyle_Link],
+            false,
+            g.style.link_thickness);
+
+        const bool link_creation_on_snap =
+            g.hovered_pin_idx.has_value() && (editor.pins.pool[g.hovered_pin_idx.value()].flags &
+                                              AttributeFlags_EnableLinkCreationOnSnap);
+
+        if (!should_snap)
+        {
+            editor.click_interaction_state.link_creation.end_pin_idx.reset();
+        }
+
+        if (g.left_mouse_released || (link_creation_on_snap && should_snap))
+        {
+            // Avoid send OnLinkCreated() events every frame if the snap link is not saved
+            // (only applies for EnableLinkCreationOnSnap)
+            if (!g.left_mouse_released &&
+                editor.click_interaction_state.link_creation.end_pin_idx == g.hovered_pin_idx)
+            {
+                break;
+            }
+
+            const bool link_created_succesfully =
+                finish_link_at_hovered_pin(editor, g.hovered_pin_idx);
+
+            if (link_created_succesfully)
+            {
+                g.element_state_change |= ElementStateChange_LinkCreated;
+            }
+        }
+
+        if (g.left_mouse_released)
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
+    case ClickInteractionType_Panning:
+    {
+        const bool dragging =
+            g.io.emulate_three_button_mouse.enabled
+                ? (g.left_mouse_dragging && (*g.io.emulate_three_button_mouse.modifier))
+                : g.middle_mouse_dragging;
+
+        if (dragging)
+        {
+            editor.panning += ImGui::GetIO().MouseDelta;
+        }
+        else
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
+    case ClickInteractionType_None:
+        break;
+    default:
+        assert(!"Unreachable code!");
+        break;
+    }
+}
+
+// [SECTION] render helpers
+
+inline ImVec2 screen_space_to_grid_space(const ImVec2& v)
+{
+    Context& g = *GImNodes;
+    const EditorContext& editor = editor_context_get();
+    return v - g.canvas_origin_screen_space - editor.panning;
+}
+
+inline ImVec2 grid_space_to_editor_space(const ImVec2& v)
+{
+    const EditorContext& editor = editor_context_get();
+    return v + editor.panning;
+}
+
+inline ImVec2 editor_space_to_screen_space(const ImVec2& v)
+{
+    Context& g = *GImNodes;
+    return g.canvas_origin_screen_space + v;
+}
+
+inline ImRect get_item_rect() { return ImRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax()); }
+
+inline ImVec2 get_node_title_bar_origin(const NodeData& node)
+{
+    return node.origin + node.layout_style.padding;
+}
+
+inline ImVec2 get_node_content_origin(const NodeData& node)
+{
+
+    const ImVec2 title_bar_height =
+        ImVec2(0.f, node.title_bar_content_rect.GetHeight() + 2.0f * node.layout_style.padding.y);
+    return node.origin + title_bar_height + node.layout_style.padding;
+}
+
+inline ImRect get_node_title_rect(const NodeData& node)
+{
+    ImRect expanded_title_rect = node.title_bar_content_rect;
+    expanded_title_rect.Expand(node.layout_style.padding);
+
+    return ImRect(
+        expanded_title_rect.Min,
+        expanded_title_rect.Min + ImVec2(node.rect.GetWidth(), 0.f) +
+            ImVec2(0.f, expanded_title_rect.GetHeight()));
+}
+
+void draw_grid(EditorContext& editor, const ImVec2& canvas_size)
+{
+    Context& g = *GImNodes;
+    const ImVec2 offset = editor.panning;
+    const float x_start = fmodf(offset.x, g.style.grid_spacing);
+    const float y_start = fmodf(offset.y, g.style.grid_spacing);
+
+    int num_lines = 0;
+    for (float x = x_start; x < canvas_size.x; x += g.style.grid_spacing)
+    {
+        ++num_lines;
+    }
+    for (float y = y_start; y < canvas_size.y; y += g.style.grid_spacing)
+    {
+        ++num_lines;
+    }
+
+    // The grid lines are axis-aligned, so each one covers exactly one row or column of pixels and
+    // doesn't need an anti-aliased fringe. They are drawn as one pixel wide rectangles, all
+    // reserved in one go.
+    const ImU32 color = g.style.colors[ColorStyle_GridLine];
+    g.canvas_draw_list->PrimReserve(6 * num_lines, 4 * num_lines);
+
+    for (float x = x_start; x < canvas_size.x; x += g.style.grid_spacing)
+    {
+        g.canvas_draw_list->PrimRect(
+            editor_space_to_screen_space(ImVec2(x, 0.0f)),
+            editor_space_to_screen_space(ImVec2(x + 1.0f, canvas_size.y)),
+            color);
+    }
+
+    for (float y = y_start; y < canvas_size.y; y += g.style.grid_spacing)
+    {
+        g.canvas_draw_list->PrimRect(
+            editor_space_to_screen_space(ImVec2(0.0f, y)),
+            editor_space_to_screen_space(ImVec2(canvas_size.x, y + 1.0f)),
+            color);
+    }
+}
+
+struct QuadOffsets
+{
+    ImVec2 top_left, bottom_left, bottom_right, top_right;
+};
+
+QuadOffsets calculate_quad_offsets(const float side_length)
+{
+    const float half_side = 0.5f * side_length;
+
+    QuadOffsets offset;
+
+    offset.top_left = ImVec2(-half_side, half_side);
+    offset.bottom_left = ImVec2(-half_side, -half_side);
+    offset.bottom_right = ImVec2(half_side, -half_side);
+    offset.top_right = ImVec2(half_side, half_side);
+
+    return offset;
+}
+
+struct TriangleOffsets
+{
+    ImVec2 top_left, bottom_left, right;
+};
+
+TriangleOffsets calculate_triangle_offsets(const float side_length)
+{
+    // Calculates the Vec2 offsets from an equilateral triangle's midpoint to
+    // its vertices. Here is how the left_offset and right_offset are
+    // calculated.
+    //
+    // For an equilateral triangle of side length s, the
+    // triangle's height, h, is h = s * sqrt(3) / 2.
+    //
+    // The length from the base to the midpoint is (1 / 3) * h. The length from
+    // the midpoint to the triangle vertex is (2 / 3) * h.
+    const float sqrt_3 = sqrtf(3.0f);
+    const float left_offset = -0.1666666666667f * sqrt_3 * side_length;
+    const float right_offset = 0.333333333333f * sqrt_3 * side_length;
+    const float vertical_offset = 0.5f * side_length;
+
+    TriangleOffsets offset;
+    offset.top_left = ImVec2(left_offset, vertical_offset);
+    offset.bottom_left = ImVec2(left_offset, -vertical_offset);
+    offset.right = ImVec2(right_offset, 0.f);
+
+    return offset;
+}
+
+void draw_pin_shape(
+    ImDrawList* const draw_list,
+    const ImVec2& pin_pos,
+    const PinShape shape,
+    const ImU32 pin_color)
+{
+    Context& g = *GImNodes;
+    static const int circle_num_segments = 8;
+
+    switch (shape)
+    {
+    case PinShape_Circle:
+    {
+        draw_list->AddCircle(
+            pin_pos,
+            g.style.pin_circle_radius,
+            pin_color,
+            circle_num_segments,
+            g.style.pin_line_thickness);
+    }
+    break;
+    case PinShape_CircleFilled:
+    {
+        draw_list->AddCircleFilled(
+            pin_pos, g.style.pin_circle_radius, pin_color, circle_num_segments);
+    }
+    break;
+    case PinShape_Quad:
+    {
+        const QuadOffsets offset = calculate_quad_offsets(g.style.pin_quad_side_length);
+        draw_list->AddQuad(
+            pin_pos + offset.top_left,
+            pin_pos + offset.bottom_left,
+            pin_pos + offset.bottom_right,
+            pin_pos + offset.top_right,
+            pin_color,
+            g.style.pin_line_thickness);
+    }
+    break;
+    case PinShape_QuadFilled:
+    {
+        const QuadOffsets offset = calculate_quad_offsets(g.style.pin_quad_side_length);
+        draw_list->AddQuadFilled(
+            pin_pos + offset.top_left,
+            pin_pos + offset.bottom_left,
+            pin_pos + offset.bottom_right,
+            pin_pos + offset.top_right,
+            pin_color);
+    }
+    break;
+    case PinShape_Triangle:
+    {
+        const TriangleOffsets offset = calculate_triangle_offsets(g.style.pin_triangle_side_length);
+        draw_list->AddTriangle(
+            pin_pos + offset.top_left,
+            pin_pos + offset.bottom_left,
+            pin_pos + offset.right,
+            pin_color,
+            // NOTE: for some weird reason, the line drawn by AddTriangle is
+            // much thinner than the lines drawn by AddCircle or AddQuad.
+            // Multiplying the line thickness by two seemed to solve the
+            // problem at a few different thickness values.
+            2.f * g.style.pin_line_thickness);
+    }
+    break;
+    case PinShape_TriangleFilled:
+    {
+        const TriangleOffsets offset = calculate_triangle_offsets(g.style.pin_triangle_side_length);
+        draw_list->AddTriangleFilled(
+            pin_pos + offset.top_left,
+            pin_pos + offset.bottom_left,
+            pin_pos + offset.right,
+            pin_color);
+    }
+    break;
+    default:
+        assert(!"Invalid PinShape value!");
+        break;
+    }
+}
+
+// Tessellates each pin shape once into g.pin_stamps. The stamps are only rebuilt when the pin
+// style, the anti-aliasing flags or the font atlas change.
+void update_pin_stamps()
+{
+    Context& g = *GImNodes;
+    PinStampKey key;
+    key.circle_radius = g.style.pin_circle_radius;
+    key.quad_side_length = g.style.pin_quad_side_length;
+    key.triangle_side_length = g.style.pin_triangle_side_length;
+    key.line_thickness = g.style.pin_line_thickness;
+    key.draw_list_flags = g.canvas_draw_list->Flags;
+    key.white_pixel_uv = ImGui::GetDrawListSharedData()->TexUvWhitePixel;
+
+    if (g.pin_stamps_built && key == g.pin_stamp_key)
+    {
+        return;
+    }
+
+    ImDrawList draw_list(ImGui::GetDrawListSharedData());
+    draw_list.Flags = key.draw_list_flags;
+    draw_list.PushClipRectFullScreen();
+    draw_list.PushTextureID(g.canvas_draw_list->_TextureIdStack.back());
+
+    for (int shape = PinShape_Circle; shape <= PinShape_QuadFilled; ++shape)
+    {
+        draw_list.VtxBuffer.resize(0);
+        draw_list.IdxBuffer.resize(0);
+        draw_list._VtxCurrentIdx = 0;
+        draw_pin_shape(&draw_list, ImVec2(0.f, 0.f), PinShape(shape), IM_COL32_WHITE);
+
+        PinStamp& stamp = g.pin_stamps[shape];
+        stamp.vertices = draw_list.VtxBuffer;
+        stamp.indices = draw_list.IdxBuffer;
+    }
+
+    g.pin_stamp_key = key;
+    g.pin_stamps_built = true;
+}
+
+// Copies the pin's stamp into the reserved space of the draw list. The caller reserves the vertices
+// and indices with PrimReserve().
+void stamp_pin(ImDrawList* const draw_list, const PinData& pin, const ImU32 pin_color)
+{
+    Context& g = *GImNodes;
+    const PinStamp& stamp = g.pin_stamps[pin.shape];
+
+    const ImDrawIdx first_idx = (ImDrawIdx)draw_list->_VtxCurrentIdx;
+    for (int i = 0; i < stamp.indices.size(); ++i)
+    {
+        draw_list->_IdxWritePtr[i] = (ImDrawIdx)(first_idx + stamp.indices[i]);
+    }
+    draw_list->_IdxWritePtr += stamp.indices.size();
+
+    for (int i = 0; i < stamp.vertices.size(); ++i)
+    {
+        const ImDrawVert& vertex = stamp.vertices[i];
+        ImDrawVert& out = draw_list->_VtxWritePtr[i];
+        out.pos = vertex.pos + pin.pos;
+        out.uv = vertex.uv;
+        out.col = vertex.col & pin_color;
+    }
+    draw_list->_VtxWritePtr += stamp.vertices.size();
+    draw_list->_VtxCurrentIdx += stamp.vertices.size();
+}
+
+ImU32 get_pin_color(const int pin_idx, const PinData& pin)
+{
+    Context& g = *GImNodes;
+    return g.hovered_pin_indices.contains(pin_idx) ? pin.color_style.hovered
+                                                   : pin.color_style.background;
+}
+
+// Draws all of the node's pins with a single draw list reservation.
+void draw_pins(ImDrawList* const draw_list, EditorContext& editor, const NodeData& node)
+{
+    Context& g = *GImNodes;
+    int idx_count = 0;
+    int vtx_count = 0;
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        const PinStamp& stamp = g.pin_stamps[editor.pins.pool[node.pin_indices[i]].shape];
+        idx_count += stamp.indices.size();
+        vtx_count += stamp.vertices.size();
+    }
+
+    // PrimReserve() may start a new draw command with a vertex offset when the 16-bit index range
+    // runs out, and that only works if the whole reservation fits in the new range.
+    if (sizeof(ImDrawIdx) == 2 && vtx_count >= (1 << 16))
+    {
+        for (int i = 0; i < node.pin_indices.size(); ++i)
+        {
+            const int pin_idx = node.pin_indices[i];
+            const PinData& pin = editor.pins.pool[pin_idx];
+            draw_pin_shape(draw_list, pin.pos, pin.shape, get_pin_color(pin_idx, pin));
         }
+        return;
+    }
 
-        // If we are within the hover radius of a receiving pin, snap the link
-        // endpoint to it
-        const ImVec2 end_pos = should_snap
-                                   ? get_screen_space_pin_coordinates(
-                                         editor, editor.pins.pool[g.hovered_pin_idx.value()])
-                                   : ImGui::GetIO().MousePos;
+    draw_list->PrimReserve(idx_count, vtx_count);
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        const int pin_idx = node.pin_indices[i];
+        const PinData& pin = editor.pins.pool[pin_idx];
+        stamp_pin(draw_list, pin, get_pin_color(pin_idx, pin));
+    }
+}
+
+// Tessellates the node's background, title bar and outline into the draw list.
+void draw_node_chrome(ImDrawList* const draw_list, const NodeData& node, const NodeChromeKey& key)
+{
+    // node base
+    draw_list->AddRectFilled(
+        node.rect.Min, node.rect.Max, key.background, key.corner_rounding);
+
+    // title bar:
+    if (node.title_bar_content_rect.GetHeight() > 0.f)
+    {
+        ImRect title_bar_rect = get_node_title_rect(node);
+
+        draw_list->AddRectFilled(
+            title_bar_rect.Min,
+            title_bar_rect.Max,
+            key.titlebar,
+            key.corner_rounding,
+            ImDrawCornerFlags_Top);
+    }
+
+    if (key.draw_outline)
+    {
+        draw_list->AddRect(node.rect.Min, node.rect.Max, key.outline, key.corner_rounding);
+    }
+}
+
+// Draws the node's chrome, reusing the cached geometry when the key hasn't changed since it was
+// tessellated. Only the node's position may differ from the cached geometry.
+void draw_cached_node_chrome(
+    ImDrawList* const draw_list,
+    NodeData& node,
+    const NodeChromeKey& key)
+{
+    NodeChromeCache& cache = node.chrome_cache;
+
+    if (cache.valid && cache.key == key)
+    {
+        draw_list->PrimReserve(cache.indices.size(), cache.vertices.size());
+
+        const ImDrawIdx first_idx = (ImDrawIdx)draw_list->_VtxCurrentIdx;
+        for (int i = 0; i < cache.indices.size(); ++i)
+        {
+            draw_list->_IdxWritePtr[i] = (ImDrawIdx)(first_idx + cache.indices[i]);
+        }
+        draw_list->_IdxWritePtr += cache.indices.size();
+
+        for (int i = 0; i < cache.vertices.size(); ++i)
+        {
+            const ImDrawVert& vertex = cache.vertices[i];
+            ImDrawVert& out = draw_list->_VtxWritePtr[i];
+            out.pos = vertex.pos + node.rect.Min;
+            out.uv = vertex.uv;
+            out.col = vertex.col;
+        }
+        draw_list->_VtxWritePtr += cache.vertices.size();
+        draw_list->_VtxCurrentIdx += cache.vertices.size();
+        return;
+    }
+
+    const int first_vertex = draw_list->VtxBuffer.Size;
+    const int first_index = draw_list->IdxBuffer.Size;
+    const unsigned int first_idx = draw_list->_VtxCurrentIdx;
+
+    draw_node_chrome(draw_list, node, key);
+
+    const int vertex_count = draw_list->VtxBuffer.Size - first_vertex;
+    const int index_count = draw_list->IdxBuffer.Size - first_index;
+    // If the draw list ran out of 16-bit indices and started a new draw command with a vertex
+    // offset, the indices aren't relative to first_idx, and the geometry can't be cached.
+    cache.valid = draw_list->_VtxCurrentIdx - first_idx == (unsigned int)vertex_count;
+    if (!cache.valid)
+    {
+        return;
+    }
+
+    cache.key = key;
+    cache.vertices.resize(vertex_count);
+    for (int i = 0; i < vertex_count; ++i)
+    {
+        cache.vertices[i] = draw_list->VtxBuffer[first_vertex + i];
+        cache.vertices[i].pos = cache.vertices[i].pos - node.rect.Min;
+    }
+    cache.indices.resize(index_count);
+    for (int i = 0; i < index_count; ++i)
+    {
+        cache.indices[i] = (ImDrawIdx)(draw_list->IdxBuffer[first_index + i] - first_idx);
+    }
+}
+
+// Fills in the key of the node's chrome as it would be drawn into the draw list, and returns the
+// node's level of detail.
+NodeLod get_node_chrome_key(
+    const ImDrawList* const draw_list,
+    EditorContext& editor,
+    const int node_idx,
+    NodeChromeKey& key)
+{
+    Context& g = *GImNodes;
+    const NodeData& node = editor.nodes.pool[node_idx];
+    const bool item_hovered = g.hovered_node_idx == node_idx;
+
+    key.size = node.rect.GetSize();
+    key.title_bar_rect = ImRect(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f));
+    if (node.title_bar_content_rect.GetHeight() > 0.f)
+    {
+        const ImRect title_bar_rect = get_node_title_rect(node);
+        key.title_bar_rect =
+            ImRect(title_bar_rect.Min - node.rect.Min, title_bar_rect.Max - node.rect.Min);
+    }
+    key.background = node.color_style.background;
+    key.titlebar = node.color_style.titlebar;
+    key.outline = node.color_style.outline;
+    key.corner_rounding = node.layout_style.corner_rounding;
+    key.draw_outline = (g.style.flags & StyleFlags_NodeOutline) != 0;
+    key.draw_list_flags = draw_list->Flags;
+    key.white_pixel_uv = draw_list->_Data->TexUvWhitePixel;
+
+    if (editor.selected_node_indices.contains(node_idx))
+    {
+        key.background = node.color_style.background_selected;
+        key.titlebar = node.color_style.titlebar_selected;
+    }
+    else if (item_hovered)
+    {
+        key.background = node.color_style.background_hovered;
+        key.titlebar = node.color_style.titlebar_hovered;
+    }
+
+    const NodeLod lod = get_node_lod(node);
+    if (lod == NodeLod_Chrome)
+    {
+        key.corner_rounding = 0.f;
+        key.draw_outline = false;
+    }
+    return lod;
+}
+
+// TODO: It may be useful to make this an EditorContext method, since this uses
+// a lot of editor state. Currently that is just not clear, since we don't pass
+// the editor as a part of the function signature.
+void draw_node(ImDrawList* const draw_list, EditorContext& editor, const int node_idx)
+{
+    NodeData& node = editor.nodes.pool[node_idx];
+    NodeChromeKey key;
+    const NodeLod lod = get_node_chrome_key(draw_list, editor, node_idx, key);
+    if (lod == NodeLod_Rect)
+    {
+        draw_list->AddRectFilled(node.rect.Min, node.rect.Max, key.background);
+        return;
+    }
+
+    draw_cached_node_chrome(draw_list, node, key);
+
+    if (lod == NodeLod_Full)
+    {
+        draw_pins(draw_list, editor, node);
+    }
+}
+
+// Copies the current node's ImGui channel into the node's content snapshot. Called at the end of
+// a live submission of a NodeFlags_Cacheable node. Nothing is recorded if the output can't be
+// replayed elsewhere on the canvas.
+void record_node_content(NodeData& node)
+{
+    Context& g = *GImNodes;
+    NodeContentSnapshot& snapshot = node.content_snapshot;
+    ImDrawList* const draw_list = g.canvas_draw_list;
+    snapshot.valid = false;
+
+    // A node which shares the last channel with the nodes before it doesn't own the channel's
+    // index buffer.
+    if (g.canvas_channels_requested > g.canvas_channels_in_use)
+    {
+        return;
+    }
+
+    // A node which overlaps the edge of the canvas may have had some of its output clipped away.
+    const ImVec4& canvas_clip_rect = draw_list->_ClipRectStack.back();
+    if (!ImRect(canvas_clip_rect).Contains(node.rect))
+    {
+        return;
+    }
+
+    // The vertex index range must not have been reset while the node was submitted.
+    const int vertex_count = draw_list->VtxBuffer.Size - g.current_node_first_vertex;
+    if (draw_list->_VtxCurrentIdx - g.current_node_first_idx != (unsigned int)vertex_count)
+    {
+        return;
+    }
+
+    snapshot.commands.resize(0);
+    for (int i = 0; i < draw_list->CmdBuffer.size(); ++i)
+    {
+        const ImDrawCmd& draw_cmd = draw_list->CmdBuffer[i];
+        if (draw_cmd.UserCallback != NULL)
+        {
+            return;
+        }
+
+        if (draw_cmd.ElemCount == 0)
+        {
+            continue;
+        }
+
+        NodeContentCommand command;
+        const ImVec4& clip_rect = draw_cmd.ClipRect;
+        command.canvas_clip =
+            clip_rect.x == canvas_clip_rect.x && clip_rect.y == canvas_clip_rect.y &&
+            clip_rect.z == canvas_clip_rect.z && clip_rect.w == canvas_clip_rect.w;
+        command.clip_rect = ImVec4(
+            clip_rect.x - node.rect.Min.x,
+            clip_rect.y - node.rect.Min.y,
+            clip_rect.z - node.rect.Min.x,
+            clip_rect.w - node.rect.Min.y);
+        command.texture_id = draw_cmd.TextureId;
+        command.elem_count = (int)draw_cmd.ElemCount;
+        snapshot.commands.push_back(command);
+    }
+
+    snapshot.vertices.resize(vertex_count);
+    for (int i = 0; i < vertex_count; ++i)
+    {
+        snapshot.vertices[i] = draw_list->VtxBuffer[g.current_node_first_vertex + i];
+        snapshot.vertices[i].pos = snapshot.vertices[i].pos - node.rect.Min;
+    }
+
+    // The channel's index buffer only holds this node's ImGui output.
+    snapshot.indices.resize(draw_list->IdxBuffer.Size);
+    for (int i = 0; i < draw_list->IdxBuffer.Size; ++i)
+    {
+        snapshot.indices[i] = (ImDrawIdx)(draw_list->IdxBuffer[i] - g.current_node_first_idx);
+    }
+
+    snapshot.draw_list_flags = draw_list->Flags;
+    snapshot.white_pixel_uv = ImGui::GetDrawListSharedData()->TexUvWhitePixel;
+    snapshot.valid = true;
+}
 
-        const LinkBezierData link_data = get_link_renderable(
-            start_pos, end_pos, pin.type, g.style.link_line_segments_per_length);
-        g.canvas_draw_list->AddBezierCurve(
-            link_data.bezier.p0,
-            link_data.bezier.p1,
-            link_data.bezier.p2,
-            link_data.bezier.p3,
-            g.style.colors[ColorStyle_Link],
-            g.style.link_thickness,
-            link_data.num_segments);
+// A cacheable node is submitted live while the mouse is over it or one of its items is active, so
+// that the user can interact with its contents.
+bool can_replay_node_content(const NodeData& node)
+{
+    Context& g = *GImNodes;
+    const NodeContentSnapshot& snapshot = node.content_snapshot;
+    const ImVec2 white_pixel_uv = ImGui::GetDrawListSharedData()->TexUvWhitePixel;
+    return snapshot.valid && !node.content_active && !node.rect.Contains(ImGui::GetMousePos()) &&
+           snapshot.draw_list_flags == g.canvas_draw_list->Flags &&
+           snapshot.white_pixel_uv.x == white_pixel_uv.x &&
+           snapshot.white_pixel_uv.y == white_pixel_uv.y;
+}
 
-        const bool link_creation_on_snap =
-            g.hovered_pin_idx.has_value() && (editor.pins.pool[g.hovered_pin_idx.value()].flags &
-                                              AttributeFlags_EnableLinkCreationOnSnap);
+// Copies the node's content snapshot into the current channel, translated to the node's current
+// position.
+void replay_node_content(const NodeData& node)
+{
+    Context& g = *GImNodes;
+    const NodeContentSnapshot& snapshot = node.content_snapshot;
+    ImDrawList* const draw_list = g.canvas_draw_list;
 
-        if (!should_snap)
+    draw_list->PrimReserve(0, snapshot.vertices.size());
+    const ImDrawIdx first_idx = (ImDrawIdx)draw_list->_VtxCurrentIdx;
+    for (int i = 0; i < snapshot.vertices.size(); ++i)
+    {
+        ImDrawVert& out = draw_list->_VtxWritePtr[i];
+        out = snapshot.vertices[i];
+        out.pos = out.pos + node.rect.Min;
+    }
+    draw_list->_VtxWritePtr += snapshot.vertices.size();
+    draw_list->_VtxCurrentIdx += snapshot.vertices.size();
+
+    const ImDrawIdx* indices = snapshot.indices.Data;
+    for (int i = 0; i < snapshot.commands.size(); ++i)
+    {
+        const NodeContentCommand& command = snapshot.commands[i];
+        if (!command.canvas_clip)
         {
-            editor.click_interaction_state.link_creation.end_pin_idx.reset();
+            draw_list->PushClipRect(
+                node.rect.Min + ImVec2(command.clip_rect.x, command.clip_rect.y),
+                node.rect.Min + ImVec2(command.clip_rect.z, command.clip_rect.w),
+                true);
         }
+        draw_list->PushTextureID(command.texture_id);
 
-        if (g.left_mouse_released || (link_creation_on_snap && should_snap))
+        draw_list->PrimReserve(command.elem_count, 0);
+        for (int j = 0; j < command.elem_count; ++j)
         {
-            // Avoid send OnLinkCreated() events every frame if the snap link is not saved
-            // (only applies for EnableLinkCreationOnSnap)
-            if (!g.left_mouse_released &&
-                editor.click_interaction_state.link_creation.end_pin_idx == g.hovered_pin_idx)
-            {
-                break;
-            }
-
-            const bool link_created_succesfully =
-                finish_link_at_hovered_pin(editor, g.hovered_pin_idx);
-
-            if (link_created_succesfully)
-            {
-                g.element_state_change |= ElementStateChange_LinkCreated;
-            }
+            draw_list->_IdxWritePtr[j] = (ImDrawIdx)(first_idx + indices[j]);
         }
+        draw_list->_IdxWritePtr += command.elem_count;
+        indices += command.elem_count;
 
-        if (g.left_mouse_released)
+        draw_list->PopTextureID();
+        if (!command.canvas_clip)
         {
-            editor.click_interaction_type = ClickInteractionType_None;
+            draw_list->PopClipRect();
         }
     }
-    break;
-    case ClickInteractionType_Panning:
+}
+
+// Adds the node and its pins to the hover grids. The node is drawn later, in EndNodeEditor().
+void submit_node(EditorContext& editor, const int node_idx)
+{
+    Context& g = *GImNodes;
+    const int order = g.submitted_node_indices.size();
+    g.submitted_node_indices.push_back(node_idx);
+    g.submitted_node_channels.push_back(g.current_node_channel);
+
+    const NodeData& node = editor.nodes.pool[node_idx];
+    // A node can only be hovered over from inside of the canvas.
+    ImRect visible_rect = node.rect;
+    visible_rect.ClipWithFull(g.canvas_rect_screen_space);
+    if (visible_rect.GetWidth() > 0.f && visible_rect.GetHeight() > 0.f)
     {
-        const bool dragging =
-            g.io.emulate_three_button_mouse.enabled
-                ? (g.left_mouse_dragging && (*g.io.emulate_three_button_mouse.modifier))
-                : g.middle_mouse_dragging;
+        g.node_grid.insert(visible_rect, node_idx, order);
+    }
 
-        if (dragging)
-        {
-            editor.panning += ImGui::GetIO().MouseDelta;
-        }
-        else
+    // The pins of a node which isn't drawn in full aren't drawn, so they can't be hovered over
+    // either. Links still connect to them.
+    const bool pins_drawn = get_node_lod(node) == NodeLod_Full;
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        const int pin_idx = node.pin_indices[i];
+        PinData& pin = editor.pins.pool[pin_idx];
+        pin.pos = get_screen_space_pin_coordinates(node.rect, pin.attribute_rect, pin.type);
+        if (pins_drawn)
         {
-            editor.click_interaction_type = ClickInteractionType_None;
+            g.pin_grid.insert(ImRect(pin.pos, pin.pos), pin_idx, order);
         }
     }
-    break;
-    case ClickInteractionType_None:
-        break;
-    default:
-        assert(!"Unreachable code!");
-        break;
-    }
 }
 
-// [SECTION] render helpers
-
-inline ImVec2 screen_space_to_grid_space(const ImVec2& v)
+// Gives the node being submitted a channel of its own for its contents, and makes it the current
+// channel. The node's background is drawn at the end of the previous channel, which places it above
+// the nodes submitted before it and beneath its own contents.
+// The canvas draw list can only be split once, in BeginNodeEditor(). When more nodes have contents
+// than during the previous frame, the nodes which don't fit share the last channel until the next
+// frame. Their backgrounds are all beneath their contents then, so overlapping nodes among them may
+// be drawn in the wrong order for a frame.
+void begin_node_channel()
 {
-    const EditorContext& editor = editor_context_get();
-    return v - g.canvas_origin_screen_space - editor.panning;
+    Context& g = *GImNodes;
+    g.canvas_channels_requested++;
+    if (g.canvas_channels_in_use < g.canvas_channel_count)
+    {
+        g.canvas_channels_in_use++;
+    }
+    const int channel = g.canvas_channels_in_use - 1;
+    g.current_node_channel = channel - 1;
+    g.canvas_draw_list->ChannelsSetCurrent(channel);
 }
 
-inline ImVec2 grid_space_to_editor_space(const ImVec2& v)
+// A node which draws nothing during submission doesn't need a channel of its own. Its background is
+// drawn at the end of the last channel. Keeping these nodes out of the channels bounds the channel
+// count by the number of nodes with contents.
+void begin_node_without_channel()
 {
-    const EditorContext& editor = editor_context_get();
-    return v + editor.panning;
+    Context& g = *GImNodes;
+    g.current_node_channel = g.canvas_channels_in_use - 1;
 }
 
-inline ImVec2 editor_space_to_screen_space(const ImVec2& v)
+// Submits a node using its layout from the previous frame, without its contents.
+void submit_node_without_contents(EditorContext& editor, const int node_idx)
 {
-    return g.canvas_origin_screen_space + v;
+    const NodeData& node = editor.nodes.pool[node_idx];
+    for (int i = 0; i < node.pin_indices.size(); ++i)
+    {
+        editor.pins.mark_in_use(node.pin_indices[i]);
+    }
+    submit_node(editor, node_idx);
 }
 
-inline ImRect get_item_rect() { return ImRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax()); }
-
-inline ImVec2 get_node_title_bar_origin(const NodeData& node)
+// Returns the median extent of a sample of the nodes submitted during the current frame. A typical
+// node covers at most four grid cells of this size.
+float get_median_submitted_node_extent(const EditorContext& editor)
 {
-    return node.origin + node.layout_style.padding;
+    Context& g = *GImNodes;
+    const int node_count = g.submitted_node_indices.size();
+    if (node_count == 0)
+    {
+        return default_node_grid_cell_size;
+    }
+
+    float extents[31];
+    const int sample_count = ImMin(node_count, IM_ARRAYSIZE(extents));
+    for (int i = 0; i < sample_count; ++i)
+    {
+        const int node_idx = g.submitted_node_indices[(int)((ImS64)i * node_count / sample_count)];
+        const ImRect& rect = editor.nodes.pool[node_idx].rect;
+        const float extent = ImMax(rect.GetWidth(), rect.GetHeight());
+        // Insertion sort, as the sample is small.
+        int j = i;
+        for (; j > 0 && extents[j - 1] > extent; --j)
+        {
+            extents[j] = extents[j - 1];
+        }
+        extents[j] = extent;
+    }
+    return extents[sample_count / 2];
 }
 
-inline ImVec2 get_node_content_origin(const NodeData& node)
+// Finds the hovered pins and node from the grids, and starts the click interactions in the same
+// order as if every submitted node had been tested in turn: a node's pins are tested before the
+// node itself, the last hovered pin wins, and the first hovered node wins.
+void resolve_hovered_nodes_and_pins(EditorContext& editor)
 {
+    Context& g = *GImNodes;
+    const ImVec2 mouse_pos = ImGui::GetIO().MousePos;
+    const float hover_radius = g.style.pin_hover_radius;
 
-    const ImVec2 title_bar_height =
-        ImVec2(0.f, node.title_bar_content_rect.GetHeight() + 2.0f * node.layout_style.padding.y);
-    return node.origin + title_bar_height + node.layout_style.padding;
-}
+    g.hovered_pin_indices.resize(0);
+    int hovered_pin_entry = -1;
+    int first_hovered_pin_order = INT_MAX;
+    {
+        const SpatialGrid& grid = g.pin_grid;
+        const int x_min = grid.cell_coordinate(mouse_pos.x - hover_radius);
+        const int x_max = grid.cell_coordinate(mouse_pos.x + hover_radius);
+        const int y_min = grid.cell_coordinate(mouse_pos.y - hover_radius);
+        const int y_max = grid.cell_coordinate(mouse_pos.y + hover_radius);
+        ImVector<int>& candidates = g.pin_hover_candidates;
+        ImVector<ImVec2>& positions = g.pin_hover_positions;
+        candidates.resize(0);
+        positions.resize(0);
+        for (int y = y_min; y <= y_max && !grid.entries.empty(); ++y)
+        {
+            for (int x = x_min; x <= x_max; ++x)
+            {
+                for (int entry_idx = grid.cells.find(SpatialGrid::cell_key(x, y)); entry_idx != -1;
+                     entry_idx = grid.entries[entry_idx].next)
+                {
+                    candidates.push_back(entry_idx);
+                    positions.push_back(editor.pins.pool[grid.entries[entry_idx].index].pos);
+                }
+            }
+        }
 
-inline ImRect get_node_title_rect(const NodeData& node)
-{
-    ImRect expanded_title_rect = node.title_bar_content_rect;
-    expanded_title_rect.Expand(node.layout_style.padding);
+        ImVector<float>& distances = g.pin_hover_distances;
+        distances.resize(candidates.size());
+        get_squared_distances(mouse_pos, positions.Data, positions.size(), distances.Data);
+        for (int i = 0; i < candidates.size(); ++i)
+        {
+            if (distances[i] >= hover_radius * hover_radius)
+            {
+                continue;
+            }
 
-    return ImRect(
-        expanded_title_rect.Min,
-        expanded_title_rect.Min + ImVec2(node.rect.GetWidth(), 0.f) +
-            ImVec2(0.f, expanded_title_rect.GetHeight()));
-}
+            const SpatialGrid::Entry& entry = grid.entries[candidates[i]];
+            g.hovered_pin_indices.push_back(entry.index);
+            first_hovered_pin_order = ImMin(first_hovered_pin_order, entry.order);
+            hovered_pin_entry = ImMax(hovered_pin_entry, candidates[i]);
+        }
+    }
 
-void draw_grid(EditorContext& editor, const ImVec2& canvas_size)
-{
-    const ImVec2 offset = editor.panning;
+    // Only the first node under the mouse cursor can become the hovered ImGui item. The entries are
+    // in submission order, so the first node has the lowest entry index.
+    int hovered_node_entry = -1;
+    for (int list = 0; list < 2; ++list)
+    {
+        for (int entry_idx = list == 0 ? g.node_grid.find_cell(mouse_pos) : g.node_grid.oversized;
+             entry_idx != -1;
+             entry_idx = g.node_grid.entries[entry_idx].next)
+        {
+            const SpatialGrid::Entry& entry = g.node_grid.entries[entry_idx];
+            if (editor.nodes.pool[entry.index].rect.Contains(mouse_pos) &&
+                (hovered_node_entry == -1 || entry_idx < hovered_node_entry))
+            {
+                hovered_node_entry = entry_idx;
+            }
+        }
+    }
 
-    for (float x = fmodf(offset.x, g.style.grid_spacing); x < canvas_size.x;
-         x += g.style.grid_spacing)
+    if (hovered_node_entry != -1)
     {
-        g.canvas_draw_list->AddLine(
-            editor_space_to_screen_space(ImVec2(x, 0.0f)),
-            editor_space_to_screen_space(ImVec2(x, canvas_size.y)),
-            g.style.colors[ColorStyle_GridLine]);
+        const NodeData& node = editor.nodes.pool[g.node_grid.entries[hovered_node_entry].index];
+        ImGui::SetCursorPos(node.origin + editor.panning);
+        // InvisibleButton's str_id can be left empty if we push our own
+        // id on the stack.
+        ImGui::PushID(node.id);
+        ImGui::InvisibleButton("", node.rect.GetSize());
+        ImGui::PopID();
+
+        if (!ImGui::IsItemHovered())
+        {
+            hovered_node_entry = -1;
+        }
     }
 
-    for (float y = fmodf(offset.y, g.style.grid_spacing); y < canvas_size.y;
-         y += g.style.grid_spacing)
+    if (hovered_node_entry != -1)
     {
-        g.canvas_draw_list->AddLine(
-            editor_space_to_screen_space(ImVec2(0.0f, y)),
-            editor_space_to_screen_space(ImVec2(canvas_size.x, y)),
-            g.style.colors[ColorStyle_GridLine]);
+        const SpatialGrid::Entry& entry = g.node_grid.entries[hovered_node_entry];
+        g.hovered_node_idx = entry.index;
+        // The node is tested before the pins of the nodes submitted after it.
+        if (g.left_mouse_clicked && entry.order < first_hovered_pin_order)
+        {
+            begin_node_selection(editor, entry.index);
+        }
+    }
+
+    if (hovered_pin_entry != -1)
+    {
+        const int pin_idx = g.pin_grid.entries[hovered_pin_entry].index;
+        g.hovered_pin_idx = pin_idx;
+        g.hovered_pin_flags = editor.pins.pool[pin_idx].flags;
+        if (g.left_mouse_clicked)
+        {
+            begin_link_creation(editor, pin_idx);
+        }
     }
 }
 
-struct QuadOffsets
+inline bool points_nearly_equal(const ImVec2& a, const ImVec2& b)
 {
-    ImVec2 top_left, bottom_left, bottom_right, top_right;
-};
+    const float tolerance = 0.01f;
+    return ImFabs(a.x - b.x) < tolerance && ImFabs(a.y - b.y) < tolerance;
+}
 
-QuadOffsets calculate_quad_offsets(const float side_length)
+// Rebuilds the link's polyline if its endpoints or the style changed. The endpoints are compared
+// with a small tolerance, as pin positions are recomputed in screen space every frame and pick up
+// rounding errors when the canvas is panned.
+void update_link_curve(const EditorContext& editor, LinkData& link)
 {
-    const float half_side = 0.5f * side_length;
-
-    QuadOffsets offset;
+    Context& g = *GImNodes;
+    const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
+    const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
+    const ImVec2 start = screen_space_to_grid_space(start_pin.pos);
+    const ImVec2 end = screen_space_to_grid_space(end_pin.pos);
+
+    const float flattening_tolerance = (g.style.flags & StyleFlags_AdaptiveLinkFlattening) != 0
+                                           ? g.style.link_flattening_tolerance
+                                           : 0.f;
+
+    LinkCurve& curve = link.curve;
+    if (!curve.points.empty() && curve.start_type == start_pin.type &&
+        curve.line_segments_per_length == g.style.link_line_segments_per_length &&
+        curve.flattening_tolerance == flattening_tolerance &&
+        points_nearly_equal(curve.start, start) && points_nearly_equal(curve.end, end))
+    {
+        return;
+    }
 
-    offset.top_left = ImVec2(-half_side, half_side);
-    offset.bottom_left = ImVec2(-half_side, -half_side);
-    offset.bottom_right = ImVec2(half_side, -half_side);
-    offset.top_right = ImVec2(half_side, half_side);
+    curve.start = start;
+    curve.end = end;
+    curve.start_type = start_pin.type;
+    curve.line_segments_per_length = g.style.link_line_segments_per_length;
+    curve.flattening_tolerance = flattening_tolerance;
 
-    return offset;
+    const LinkBezierData link_data =
+        get_link_renderable(start, end, start_pin.type, curve.line_segments_per_length);
+    curve.bezier = link_data.bezier;
+    flatten_link(link_data, curve.points);
 }
 
-struct TriangleOffsets
-{
-    ImVec2 top_left, bottom_left, right;
-};
-
-TriangleOffsets calculate_triangle_offsets(const float side_length)
+// The link's rectangle, which contains the curve and its hover area, in grid space.
+inline ImRect get_link_grid_space_rect(const LinkData& link)
 {
-    // Calculates the Vec2 offsets from an equilateral triangle's midpoint to
-    // its vertices. Here is how the left_offset and right_offset are
-    // calculated.
-    //
-    // For an equilateral triangle of side length s, the
-    // triangle's height, h, is h = s * sqrt(3) / 2.
-    //
-    // The length from the base to the midpoint is (1 / 3) * h. The length from
-    // the midpoint to the triangle vertex is (2 / 3) * h.
-    const float sqrt_3 = sqrtf(3.0f);
-    const float left_offset = -0.1666666666667f * sqrt_3 * side_length;
-    const float right_offset = 0.333333333333f * sqrt_3 * side_length;
-    const float vertical_offset = 0.5f * side_length;
-
-    TriangleOffsets offset;
-    offset.top_left = ImVec2(left_offset, vertical_offset);
-    offset.bottom_left = ImVec2(left_offset, -vertical_offset);
-    offset.right = ImVec2(right_offset, 0.f);
-
-    return offset;
+    return get_containing_rect_for_bezier_curve(link.curve.bezier);
 }
 
-void draw_pin_shape(const ImVec2& pin_pos, const PinData& pin, const ImU32 pin_color)
+// Rebuilds the link BVH if the set of submitted links changed since the last frame, and refits
+// it otherwise.
+void update_link_bvh(EditorContext& editor)
 {
-    static const int circle_num_segments = 8;
+    Context& g = *GImNodes;
+    LinkBvh& bvh = editor.link_bvh;
+    const ImVector<ImU32>& submitted_links = editor.links.in_use;
 
-    switch (pin.shape)
+    bool links_changed = bvh.link_set.size() != submitted_links.size();
+    if (!links_changed && !submitted_links.empty())
     {
-    case PinShape_Circle:
+        links_changed = memcmp(
+                            bvh.link_set.Data,
+                            submitted_links.Data,
+                            sizeof(ImU32) * submitted_links.size()) != 0;
+    }
+
+    if (links_changed)
     {
-        g.canvas_draw_list->AddCircle(
-            pin_pos,
-            g.style.pin_circle_radius,
-            pin_color,
-            circle_num_segments,
-            g.style.pin_line_thickness);
+        ImVector<LinkBvh::Item> items;
+        for (int link_idx = editor.links.first_in_use(); link_idx != -1;
+             link_idx = editor.links.next_in_use(link_idx))
+        {
+            LinkBvh::Item item;
+            item.bounds = get_link_grid_space_rect(editor.links.pool[link_idx]);
+            item.link_idx = link_idx;
+            items.push_back(item);
+        }
+        bvh.build(items, editor.links.pool.size());
+        bvh.link_set = submitted_links;
     }
-    break;
-    case PinShape_CircleFilled:
+    else
     {
-        g.canvas_draw_list->AddCircleFilled(
-            pin_pos, g.style.pin_circle_radius, pin_color, circle_num_segments);
+        for (int link_idx = editor.links.first_in_use(); link_idx != -1;
+             link_idx = editor.links.next_in_use(link_idx))
+        {
+            bvh.refit(link_idx, get_link_grid_space_rect(editor.links.pool[link_idx]));
+        }
     }
-    break;
-    case PinShape_Quad:
+
+    g.link_hover_candidates.clear();
+    ImVector<int>& candidates = g.link_query_results;
+    candidates.resize(0);
+    const ImVec2 mouse_pos = screen_space_to_grid_space(ImGui::GetIO().MousePos);
+    bvh.query(ImRect(mouse_pos, mouse_pos), candidates);
+    for (int i = 0; i < candidates.size(); ++i)
     {
-        const QuadOffsets offset = calculate_quad_offsets(g.style.pin_quad_side_length);
-        g.canvas_draw_list->AddQuad(
-            pin_pos + offset.top_left,
-            pin_pos + offset.bottom_left,
-            pin_pos + offset.bottom_right,
-            pin_pos + offset.top_right,
-            pin_color,
-            g.style.pin_line_thickness);
+        g.link_hover_candidates.push_back(candidates[i]);
     }
-    break;
-    case PinShape_QuadFilled:
+}
+
+// Resolves the hovering of the link and begins its interactions, and finds the color which the link
+// is drawn with. Returns false if the link isn't drawn.
+bool prepare_link(EditorContext& editor, const int link_idx, ImU32* const link_color)
+{
+    Context& g = *GImNodes;
+    const LinkData& link = editor.links.pool[link_idx];
+    const ImVec2 grid_space_origin = g.canvas_origin_screen_space + editor.panning;
+
+    // The curve is contained by the convex hull of its control points. If the hull doesn't
+    // overlap the canvas, then the link can't be seen or hovered over.
+    const ImRect link_rect = get_link_grid_space_rect(link);
+    const ImRect canvas_rect(
+        g.canvas_rect_screen_space.Min - grid_space_origin,
+        g.canvas_rect_screen_space.Max - grid_space_origin);
+    if (!canvas_rect.Overlaps(link_rect))
     {
-        const QuadOffsets offset = calculate_quad_offsets(g.style.pin_quad_side_length);
-        g.canvas_draw_list->AddQuadFilled(
-            pin_pos + offset.top_left,
-            pin_pos + offset.bottom_left,
-            pin_pos + offset.bottom_right,
-            pin_pos + offset.top_right,
-            pin_color);
+        g.io.metrics_culled_links++;
+        return false;
     }
-    break;
-    case PinShape_Triangle:
+
+    const bool is_hovered =
+        g.link_hover_candidates.contains(link_idx) &&
+        is_mouse_hovering_near_link(
+            ImGui::GetIO().MousePos - grid_space_origin, link.curve, link_rect);
+    if (is_hovered)
     {
-        const TriangleOffsets offset = calculate_triangle_offsets(g.style.pin_triangle_side_length);
-        g.canvas_draw_list->AddTriangle(
-            pin_pos + offset.top_left,
-            pin_pos + offset.bottom_left,
-            pin_pos + offset.right,
-            pin_color,
-            // NOTE: for some weird reason, the line drawn by AddTriangle is
-            // much thinner than the lines drawn by AddCircle or AddQuad.
-            // Multiplying the line thickness by two seemed to solve the
-            // problem at a few different thickness values.
-            2.f * g.style.pin_line_thickness);
+        g.hovered_link_idx = link_idx;
+        if (g.left_mouse_clicked)
+        {
+            begin_link_interaction(editor, link_idx);
+        }
     }
-    break;
-    case PinShape_TriangleFilled:
+
+    // It's possible for a link to be deleted in begin_link_interaction. A user
+    // may detach a link, resulting in the link wire snapping to the mouse
+    // position.
+    //
+    // In other words, skip rendering the link if it was deleted.
+    if (g.deleted_link_idx == link_idx)
     {
-        const TriangleOffsets offset = calculate_triangle_offsets(g.style.pin_triangle_side_length);
-        g.canvas_draw_list->AddTriangleFilled(
-            pin_pos + offset.top_left,
-            pin_pos + offset.bottom_left,
-            pin_pos + offset.right,
-            pin_color);
+        return false;
+    }
+
+    *link_color = link.color_style.base;
+    if (editor.selected_link_indices.contains(link_idx))
+    {
+        *link_color = link.color_style.selected;
     }
-    break;
-    default:
-        assert(!"Invalid PinShape value!");
-        break;
+    else if (is_hovered)
+    {
+        *link_color = link.color_style.hovered;
     }
+    g.io.metrics_rendered_links++;
+    return true;
 }
 
-void draw_pin(EditorContext& editor, const int pin_idx, const bool left_mouse_clicked)
+// Tessellates the link's curve into the draw list. The points are scratch space for the curve's
+// screen space points.
+void draw_link_geometry(
+    ImDrawList* const draw_list,
+    ImVector<ImVec2>& points,
+    const EditorContext& editor,
+    const int link_idx,
+    const ImU32 link_color)
 {
-    PinData& pin = editor.pins.pool[pin_idx];
-    const ImRect& parent_node_rect = editor.nodes.pool[pin.parent_node_idx].rect;
-
-    pin.pos = get_screen_space_pin_coordinates(parent_node_rect, pin.attribute_rect, pin.type);
-
-    ImU32 pin_color = pin.color_style.background;
+    Context& g = *GImNodes;
+    const LinkData& link = editor.links.pool[link_idx];
+    const ImVec2 grid_space_origin = g.canvas_origin_screen_space + editor.panning;
 
-    if (is_mouse_hovering_near_point(pin.pos, g.style.pin_hover_radius))
+    points.resize(link.curve.points.size());
+    for (int i = 0; i < points.size(); ++i)
     {
-        g.hovered_pin_idx = pin_idx;
-        g.hovered_pin_flags = pin.flags;
-        pin_color = pin.color_style.hovered;
-
-        if (left_mouse_clicked)
-        {
-            begin_link_creation(editor, pin_idx);
-        }
+        points[i] = link.curve.points[i] + grid_space_origin;
     }
-
-    draw_pin_shape(pin.pos, pin, pin_color);
+    draw_list->AddPolyline(points.Data, points.size(), link_color, false, g.style.link_thickness);
 }
 
-// TODO: It may be useful to make this an EditorContext method, since this uses
-// a lot of editor state. Currently that is just not clear, since we don't pass
-// the editor as a part of the function signature.
-void draw_node(EditorContext& editor, const int node_idx)
+// The number of links or nodes whose geometry each draw job builds. If there aren't enough items
+// for more than one job, they're drawn on the main thread.
+const int links_per_draw_job = 256;
+const int nodes_per_draw_job = 64;
+
+// Describes the draw jobs of a frame. Job i builds the geometry of the items in
+// [i * items_per_job, (i + 1) * items_per_job) into g.draw_jobs[i].
+struct DrawJobBatch
 {
-    const NodeData& node = editor.nodes.pool[node_idx];
-    ImGui::SetCursorPos(node.origin + editor.panning);
-    // InvisibleButton's str_id can be left empty if we push our own
-    // id on the stack.
-    ImGui::PushID(node.id);
-    ImGui::InvisibleButton("", node.rect.GetSize());
-    ImGui::PopID();
+    Context* ctx;
+    EditorContext* editor;
+    int item_count;
+    int items_per_job;
+    void (*draw_item)(DrawJob& job, EditorContext& editor, int item_index);
+};
 
-    const bool item_hovered = ImGui::IsItemHovered();
+// The functions which tell the main thread how much of a job's draw list and scratch space an item
+// may use. They return false if the item can't be drawn by a job without allocating memory, in
+// which case it's drawn on the main thread.
+typedef bool (*DrawJobItemMeasure)(DrawJob& job, EditorContext& editor, int item_index);
 
-    ImU32 node_background = node.color_style.background;
-    ImU32 titlebar_background = node.color_style.titlebar;
+// AddPolyline() adds at most 4 vertices and 18 indices per point.
+bool measure_link_job_item(DrawJob& job, EditorContext& editor, const int item_index)
+{
+    const LinkDrawItem& item = GImNodes->link_draw_items[item_index];
+    const int point_count = editor.links.pool[item.link_idx].curve.points.size();
+    job.reserved_vertices += 4 * point_count;
+    job.reserved_indices += 18 * point_count;
+    job.reserved_points = ImMax(job.reserved_points, point_count);
+    return true;
+}
 
-    if (editor.selected_node_indices.contains(node_idx))
-    {
-        node_background = node.color_style.background_selected;
-        titlebar_background = node.color_style.titlebar_selected;
-    }
-    else if (item_hovered)
+void draw_link_job_item(DrawJob& job, EditorContext& editor, const int item_index)
+{
+    const LinkDrawItem& item = GImNodes->link_draw_items[item_index];
+    draw_link_geometry(job.draw_list, job.points, editor, item.link_idx, item.color);
+}
+
+// A job only replays the node's cached chrome, so the cache is brought up to date here. The chrome
+// is tessellated into the job's draw list, which is emptied again before the job runs.
+bool measure_node_job_item(DrawJob& job, EditorContext& editor, const int item_index)
+{
+    Context& g = *GImNodes;
+    ImDrawList* const draw_list = job.draw_list;
+    NodeData& node = editor.nodes.pool[g.submitted_node_indices[item_index]];
+    NodeChromeKey key;
+    const NodeLod lod =
+        get_node_chrome_key(draw_list, editor, g.submitted_node_indices[item_index], key);
+    if (lod == NodeLod_Rect)
     {
-        node_background = node.color_style.background_hovered;
-        titlebar_background = node.color_style.titlebar_hovered;
+        job.reserved_vertices += 4;
+        job.reserved_indices += 6;
+        return true;
     }
 
+    const NodeChromeCache& cache = node.chrome_cache;
+    if (!cache.valid || !(cache.key == key))
     {
-        // node base
-        g.canvas_draw_list->AddRectFilled(
-            node.rect.Min, node.rect.Max, node_background, node.layout_style.corner_rounding);
-
-        // title bar:
-        if (node.title_bar_content_rect.GetHeight() > 0.f)
+        if (sizeof(ImDrawIdx) == 2 && draw_list->_VtxCurrentIdx >= (1 << 15))
         {
-            ImRect title_bar_rect = get_node_title_rect(node);
-
-            g.canvas_draw_list->AddRectFilled(
-                title_bar_rect.Min,
-                title_bar_rect.Max,
-                titlebar_background,
-                node.layout_style.corner_rounding,
-                ImDrawCornerFlags_Top);
+            draw_list->_VtxCurrentIdx = 0;
         }
-
-        if ((g.style.flags & StyleFlags_NodeOutline) != 0)
+        draw_cached_node_chrome(draw_list, node, key);
+        if (!cache.valid)
         {
-            g.canvas_draw_list->AddRect(
-                node.rect.Min,
-                node.rect.Max,
-                node.color_style.outline,
-                node.layout_style.corner_rounding);
+            return false;
         }
     }
+    job.reserved_vertices += cache.vertices.size();
+    job.reserved_indices += cache.indices.size();
 
-    for (int i = 0; i < node.pin_indices.size(); ++i)
+    if (lod == NodeLod_Full)
     {
-        draw_pin(editor, node.pin_indices[i], g.left_mouse_clicked);
+        int vtx_count = 0;
+        for (int i = 0; i < node.pin_indices.size(); ++i)
+        {
+            const PinStamp& stamp = g.pin_stamps[editor.pins.pool[node.pin_indices[i]].shape];
+            vtx_count += stamp.vertices.size();
+            job.reserved_indices += stamp.indices.size();
+        }
+        // Pins which don't fit in the 16-bit index range are tessellated one by one.
+        if (sizeof(ImDrawIdx) == 2 && vtx_count >= (1 << 16))
+        {
+            return false;
+        }
+        job.reserved_vertices += vtx_count;
     }
+    return true;
+}
+
+void draw_node_job_item(DrawJob& job, EditorContext& editor, const int item_index)
+{
+    draw_node(job.draw_list, editor, GImNodes->submitted_node_indices[item_index]);
+}
 
-    if (item_hovered)
+void run_draw_job(void* const job_data, const int job_index)
+{
+    const DrawJobBatch& batch = *static_cast<const DrawJobBatch*>(job_data);
+    const JobContextScope scope(batch.ctx);
+    DrawJob& job = *batch.ctx->draw_jobs[job_index];
+    ImDrawList* const draw_list = job.draw_list;
+
+    const int first_item = job_index * batch.items_per_job;
+    const int last_item = ImMin(first_item + batch.items_per_job, batch.item_count);
+    for (int i = first_item; i < last_item; ++i)
     {
-        g.hovered_node_idx = node_idx;
-        if (g.left_mouse_clicked)
+        DrawJobItem& item = batch.ctx->draw_job_items[i];
+        if (!item.valid)
+        {
+            continue;
+        }
+
+        // The items are copied out with indices relative to their first vertex, so the vertex
+        // index range can start over between items. This keeps 16-bit indices from running out.
+        if (sizeof(ImDrawIdx) == 2 && draw_list->_VtxCurrentIdx >= (1 << 15))
         {
-            begin_node_selection(editor, node_idx);
+            draw_list->_VtxCurrentIdx = 0;
         }
+
+        item.first_vertex = draw_list->VtxBuffer.Size;
+        item.first_index = draw_list->IdxBuffer.Size;
+        item.first_idx = draw_list->_VtxCurrentIdx;
+
+        batch.draw_item(job, *batch.editor, i);
+
+        item.vertex_count = draw_list->VtxBuffer.Size - item.first_vertex;
+        item.index_count = draw_list->IdxBuffer.Size - item.first_index;
+        item.valid = draw_list->_VtxCurrentIdx - item.first_idx == (unsigned int)item.vertex_count;
     }
 }
 
-void draw_link(EditorContext& editor, const int link_idx)
+// Builds the geometry of item_count links or nodes with io.job_dispatch. Returns false if no
+// dispatcher is set, or if there are too few items to be worth splitting into jobs, in which case
+// nothing was drawn.
+bool run_draw_jobs(
+    EditorContext& editor,
+    const int item_count,
+    const int items_per_job,
+    const DrawJobItemMeasure measure_item,
+    void (*draw_item)(DrawJob& job, EditorContext& editor, int item_index))
 {
-    const LinkData& link = editor.links.pool[link_idx];
-    const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
-    const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
-
-    const LinkBezierData link_data = get_link_renderable(
-        start_pin.pos, end_pin.pos, start_pin.type, g.style.link_line_segments_per_length);
+    Context& g = *GImNodes;
+    if (g.io.job_dispatch.dispatch == NULL || item_count <= items_per_job)
+    {
+        return false;
+    }
 
-    const bool is_hovered = is_mouse_hovering_near_link(link_data.bezier, link_data.num_segments);
-    if (is_hovered)
+    const int job_count = (item_count + items_per_job - 1) / items_per_job;
+    while (g.draw_jobs.size() < job_count)
     {
-        g.hovered_link_idx = link_idx;
-        if (g.left_mouse_clicked)
+        g.draw_jobs.push_back(IM_NEW(DrawJob)(g.canvas_draw_list->_Data));
+    }
+    g.draw_job_items.resize(item_count);
+    for (int i = 0; i < job_count; ++i)
+    {
+        DrawJob& job = *g.draw_jobs[i];
+        ImDrawList* const draw_list = job.draw_list;
+        draw_list->_Data = g.canvas_draw_list->_Data;
+        draw_list->Clear();
+        draw_list->Flags = g.canvas_draw_list->Flags;
+        draw_list->AddDrawCmd();
+
+        job.reserved_vertices = 0;
+        job.reserved_indices = 0;
+        job.reserved_points = 0;
+        const int first_item = i * items_per_job;
+        const int last_item = ImMin(first_item + items_per_job, item_count);
+        for (int item_index = first_item; item_index < last_item; ++item_index)
         {
-            begin_link_interaction(editor, link_idx);
+            g.draw_job_items[item_index].valid = measure_item(job, editor, item_index);
         }
-    }
 
-    // It's possible for a link to be deleted in begin_link_interaction. A user
-    // may detach a link, resulting in the link wire snapping to the mouse
-    // position.
-    //
-    // In other words, skip rendering the link if it was deleted.
-    if (g.deleted_link_idx == link_idx)
-    {
-        return;
+        // Each item reserves its geometry at most twice, and each reservation may start a new
+        // draw command when the 16-bit index range runs out.
+        draw_list->Clear();
+        draw_list->Flags = g.canvas_draw_list->Flags;
+        draw_list->VtxBuffer.reserve(job.reserved_vertices);
+        draw_list->IdxBuffer.reserve(job.reserved_indices);
+        draw_list->CmdBuffer.reserve(2 * (last_item - first_item) + 1);
+        draw_list->AddDrawCmd();
+        job.points.reserve(job.reserved_points);
     }
 
-    ImU32 link_color = link.color_style.base;
-    if (editor.selected_link_indices.contains(link_idx))
+    DrawJobBatch batch = {&g, &editor, item_count, items_per_job, draw_item};
+    dispatch_jobs(run_draw_job, &batch, job_count);
+    return true;
+}
+
+// Copies the geometry which a draw job built for an item to the end of the canvas draw list.
+// Returns false if the item isn't valid, in which case it has to be drawn on the canvas instead.
+bool splice_draw_job_item(const int item_index, const int items_per_job)
+{
+    Context& g = *GImNodes;
+    const DrawJobItem& item = g.draw_job_items[item_index];
+    if (!item.valid)
     {
-        link_color = link.color_style.selected;
+        return false;
     }
-    else if (is_hovered)
+
+    const ImDrawList& source = *g.draw_jobs[item_index / items_per_job]->draw_list;
+    ImDrawList* const draw_list = g.canvas_draw_list;
+    draw_list->PrimReserve(item.index_count, item.vertex_count);
+
+    const ImDrawIdx* const indices = source.IdxBuffer.Data + item.first_index;
+    ImDrawIdx* const out = draw_list->_IdxWritePtr;
+    const unsigned int idx_offset = draw_list->_VtxCurrentIdx - item.first_idx;
+    for (int i = 0; i < item.index_count; ++i)
     {
-        link_color = link.color_style.hovered;
+        out[i] = (ImDrawIdx)(indices[i] + idx_offset);
     }
+    draw_list->_IdxWritePtr += item.index_count;
+
+    memcpy(
+        draw_list->_VtxWritePtr,
+        source.VtxBuffer.Data + item.first_vertex,
+        item.vertex_count * sizeof(ImDrawVert));
+    draw_list->_VtxWritePtr += item.vertex_count;
+    draw_list->_VtxCurrentIdx += item.vertex_count;
+    return true;
+}
+
+void apply_current_node_style(NodeData& node)
+{
+    Context& g = *GImNodes;
+    node.color_style.background = g.style.colors[ColorStyle_NodeBackground];
+    node.color_style.background_hovered = g.style.colors[ColorStyle_NodeBackgroundHovered];
+    node.color_style.background_selected = g.style.colors[ColorStyle_NodeBackgroundSelected];
+    node.color_style.outline = g.style.colors[ColorStyle_NodeOutline];
+    node.color_style.titlebar = g.style.colors[ColorStyle_TitleBar];
+    node.color_style.titlebar_hovered = g.style.colors[ColorStyle_TitleBarHovered];
+    node.color_style.titlebar_selected = g.style.colors[ColorStyle_TitleBarSelected];
+    node.layout_style.corner_rounding = g.style.node_corner_rounding;
+    node.layout_style.padding =
+        ImVec2(g.style.node_padding_horizontal, g.style.node_padding_vertical);
+}
 
-    g.canvas_draw_list->AddBezierCurve(
-        link_data.bezier.p0,
-        link_data.bezier.p1,
-        link_data.bezier.p2,
-        link_data.bezier.p3,
-        link_color,
-        g.style.link_thickness,
-        link_data.num_segments);
+void apply_current_pin_style(
+    PinData& pin,
+    const int id,
+    const AttributeType type,
+    const PinShape shape,
+    const int node_idx)
+{
+    Context& g = *GImNodes;
+    pin.id = id;
+    pin.parent_node_idx = node_idx;
+    pin.type = type;
+    pin.shape = shape;
+    pin.flags = g.current_attribute_flags;
+    pin.color_style.background = g.style.colors[ColorStyle_Pin];
+    pin.color_style.hovered = g.style.colors[ColorStyle_PinHovered];
 }
 
 void begin_pin_attribute(
@@ -1399,6 +3998,7 @@ void begin_pin_attribute(
     const PinShape shape,
     const int node_idx)
 {
+    Context& g = *GImNodes;
     // Make sure to call BeginNode() before calling
     // BeginAttribute()
     assert(g.current_scope == Scope_Node);
@@ -1413,18 +4013,12 @@ void begin_pin_attribute(
 
     const int pin_idx = editor.pins.find_or_create_index_for(id);
     g.current_pin_idx = pin_idx;
-    PinData& pin = editor.pins.pool[pin_idx];
-    pin.id = id;
-    pin.parent_node_idx = node_idx;
-    pin.type = type;
-    pin.shape = shape;
-    pin.flags = g.current_attribute_flags;
-    pin.color_style.background = g.style.colors[ColorStyle_Pin];
-    pin.color_style.hovered = g.style.colors[ColorStyle_PinHovered];
+    apply_current_pin_style(editor.pins.pool[pin_idx], id, type, shape, node_idx);
 }
 
 void end_pin_attribute()
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Attribute);
     g.current_scope = Scope_Node;
 
@@ -1451,14 +4045,22 @@ IO::EmulateThreeButtonMouse::EmulateThreeButtonMouse() : enabled(false), modifie
 
 IO::LinkDetachWithModifierClick::LinkDetachWithModifierClick() : modifier(NULL) {}
 
-IO::IO() : emulate_three_button_mouse(), link_detach_with_modifier_click() {}
+IO::JobDispatch::JobDispatch() : dispatch(NULL), user_data(NULL) {}
+
+IO::IO()
+    : emulate_three_button_mouse(), link_detach_with_modifier_click(), job_dispatch(),
+      metrics_rendered_links(0), metrics_culled_links(0)
+{
+}
 
 Style::Style()
     : grid_spacing(32.f), node_corner_rounding(4.f), node_padding_horizontal(8.f),
       node_padding_vertical(8.f), link_thickness(3.f), link_line_segments_per_length(0.1f),
-      link_hover_distance(10.f), pin_circle_radius(4.f), pin_quad_side_length(7.f),
-      pin_triangle_side_length(9.5), pin_line_thickness(1.f), pin_hover_radius(10.f),
-      pin_offset(0.f), flags(StyleFlags(StyleFlags_NodeOutline | StyleFlags_GridLines)), colors()
+      link_hover_distance(10.f), link_flattening_tolerance(0.25f), pin_circle_radius(4.f),
+      pin_quad_side_length(7.f), pin_triangle_side_length(9.5), pin_line_thickness(1.f),
+      pin_hover_radius(10.f), pin_offset(0.f), node_lod_chrome_size(12.f),
+      node_lod_rect_size(6.f),
+      flags(StyleFlags(StyleFlags_NodeOutline | StyleFlags_GridLines)), colors()
 {
 }
 
@@ -1475,7 +4077,7 @@ void EditorContextFree(EditorContext* ctx)
     ImGui::MemFree(ctx);
 }
 
-void EditorContextSet(EditorContext* ctx) { g.editor_ctx = ctx; }
+void EditorContextSet(EditorContext* ctx) { GImNodes->editor_ctx = ctx; }
 
 ImVec2 EditorContextGetPanning()
 {
@@ -1498,40 +4100,67 @@ void EditorContextMoveToNode(const int node_id)
     editor.panning.y = -node.origin.y;
 }
 
-void Initialize()
+Context* CreateContext()
 {
-    assert(initialized == false);
-    initialized = true;
-
-    g.default_editor_ctx = NULL;
-    g.editor_ctx = NULL;
-    g.canvas_origin_screen_space = ImVec2(0.0f, 0.0f);
-    g.canvas_rect_screen_space = ImRect(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f));
-    g.current_scope = Scope_None;
+    Context* const prev_ctx = GImNodes;
+    void* mem = ImGui::MemAlloc(sizeof(Context));
+    Context* const ctx = new (mem) Context();
+    SetCurrentContext(ctx);
 
-    g.current_pin_idx = INT_MAX;
-    g.current_node_idx = INT_MAX;
-
-    g.default_editor_ctx = EditorContextCreate();
-    EditorContextSet(g.default_editor_ctx);
+    ctx->default_editor_ctx = EditorContextCreate();
+    EditorContextSet(ctx->default_editor_ctx);
 
     const ImGuiIO& io = ImGui::GetIO();
-    g.io.emulate_three_button_mouse.modifier = &io.KeyAlt;
+    ctx->io.emulate_three_button_mouse.modifier = &io.KeyAlt;
 
-    g.current_attribute_flags = AttributeFlags_None;
-    g.attribute_flag_stack.push_back(g.current_attribute_flags);
+    ctx->attribute_flag_stack.push_back(ctx->current_attribute_flags);
 
     StyleColorsDark();
+
+    // Like ImGui::CreateContext(), the new context only becomes the current one if there was none.
+    if (prev_ctx != NULL)
+    {
+        SetCurrentContext(prev_ctx);
+    }
+    return ctx;
+}
+
+void DestroyContext(Context* ctx)
+{
+    if (ctx == NULL)
+    {
+        ctx = GImNodes;
+    }
+    assert(ctx != NULL);
+
+    if (GImNodes == ctx)
+    {
+        SetCurrentContext(NULL);
+    }
+    EditorContextFree(ctx->default_editor_ctx);
+    ctx->~Context();
+    ImGui::MemFree(ctx);
+}
+
+Context* GetCurrentContext() { return GImNodes; }
+
+void SetCurrentContext(Context* ctx) { GImNodes = ctx; }
+
+void Initialize()
+{
+    assert(GImNodes == NULL);
+    CreateContext();
 }
 
-void Shutdown() { EditorContextFree(g.default_editor_ctx); }
+void Shutdown() { DestroyContext(); }
 
-IO& GetIO() { return g.io; }
+IO& GetIO() { return GImNodes->io; }
 
-Style& GetStyle() { return g.style; }
+Style& GetStyle() { return GImNodes->style; }
 
 void StyleColorsDark()
 {
+    Context& g = *GImNodes;
     g.style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
     g.style.colors[ColorStyle_NodeBackgroundHovered] = IM_COL32(75, 75, 75, 255);
     g.style.colors[ColorStyle_NodeBackgroundSelected] = IM_COL32(75, 75, 75, 255);
@@ -1557,6 +4186,7 @@ void StyleColorsDark()
 
 void StyleColorsClassic()
 {
+    Context& g = *GImNodes;
     g.style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
     g.style.colors[ColorStyle_NodeBackgroundHovered] = IM_COL32(75, 75, 75, 255);
     g.style.colors[ColorStyle_NodeBackgroundSelected] = IM_COL32(75, 75, 75, 255);
@@ -1577,6 +4207,7 @@ void StyleColorsClassic()
 
 void StyleColorsLight()
 {
+    Context& g = *GImNodes;
     g.style.colors[ColorStyle_NodeBackground] = IM_COL32(240, 240, 240, 255);
     g.style.colors[ColorStyle_NodeBackgroundHovered] = IM_COL32(240, 240, 240, 255);
     g.style.colors[ColorStyle_NodeBackgroundSelected] = IM_COL32(240, 240, 240, 255);
@@ -1601,8 +4232,9 @@ void StyleColorsLight()
 
 void BeginNodeEditor()
 {
+    Context& g = *GImNodes;
     // Remember to call Initialize() before calling BeginNodeEditor()
-    assert(initialized);
+    assert(GImNodes != NULL);
     assert(g.current_scope == Scope_None);
     g.current_scope = Scope_Editor;
 
@@ -1617,6 +4249,9 @@ void BeginNodeEditor()
 
     g.element_state_change = ElementStateChange_None;
 
+    g.io.metrics_rendered_links = 0;
+    g.io.metrics_culled_links = 0;
+
     g.left_mouse_clicked = ImGui::IsMouseClicked(0);
     g.left_mouse_released = ImGui::IsMouseReleased(0);
     g.middle_mouse_clicked = ImGui::IsMouseClicked(2);
@@ -1630,6 +4265,14 @@ void BeginNodeEditor()
     editor.nodes.update();
     editor.pins.update();
     editor.links.update();
+    editor.link_pin_pairs.clear();
+
+    g.submitted_node_indices.resize(0);
+    g.submitted_node_channels.resize(0);
+    g.node_grid.reset(editor.node_grid_cell_size);
+    // Pins are points, so the cells only need to be large enough for a hover query to cover a few
+    // of them.
+    g.pin_grid.reset(2.f * g.style.pin_hover_radius);
 
     ImGui::BeginGroup();
     {
@@ -1648,6 +4291,7 @@ void BeginNodeEditor()
         // BeginChild(), otherwise the ImGui UI elements are going to be
         // rendered into the parent window draw list.
         g.canvas_draw_list = ImGui::GetWindowDrawList();
+        update_pin_stamps();
 
         {
             const ImVec2 canvas_size = ImGui::GetWindowSize();
@@ -1660,21 +4304,84 @@ void BeginNodeEditor()
                 draw_grid(editor, canvas_size);
             }
         }
+
+        // Split the canvas once for all the nodes. Each node with contents needs a channel, and
+        // some more channels leave room for new nodes. Before the first frame, every node which
+        // is already known may need one.
+        const int num_node_channels = editor.num_node_channels != 0
+                                          ? editor.num_node_channels
+                                          : editor.nodes.pool.size() + 1;
+        g.canvas_channel_count = num_node_channels + num_node_channels / 8 + 8;
+        g.canvas_channels_in_use = 1;
+        g.canvas_channels_requested = 1;
+        g.canvas_draw_list->ChannelsSplit(g.canvas_channel_count);
     }
 }
 
 void EndNodeEditor()
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Editor);
     g.current_scope = Scope_None;
 
     EditorContext& editor = editor_context_get();
 
-    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    resolve_hovered_nodes_and_pins(editor);
+    editor.node_grid_cell_size = get_median_submitted_node_extent(editor);
+    editor.num_node_channels = g.canvas_channels_requested;
+
+    const bool nodes_drawn_by_jobs = run_draw_jobs(
+        editor,
+        g.submitted_node_indices.size(),
+        nodes_per_draw_job,
+        measure_node_job_item,
+        draw_node_job_item);
+    for (int i = 0; i < g.submitted_node_indices.size(); ++i)
+    {
+        g.canvas_draw_list->ChannelsSetCurrent(g.submitted_node_channels[i]);
+        if (!nodes_drawn_by_jobs || !splice_draw_job_item(i, nodes_per_draw_job))
+        {
+            draw_node(g.canvas_draw_list, editor, g.submitted_node_indices[i]);
+        }
+    }
+
+    for (int link_idx = editor.links.first_in_use(); link_idx != -1;
+         link_idx = editor.links.next_in_use(link_idx))
     {
-        if (editor.links.in_use[link_idx])
+        update_link_curve(editor, editor.links.pool[link_idx]);
+    }
+    update_link_bvh(editor);
+
+    // Flatten the node channels into the canvas draw list. Links and the click interaction UI are
+    // rendered on top of the nodes.
+    g.canvas_draw_list->ChannelsMerge();
+
+    // The interactions are resolved in link order before any link is drawn, so that the links'
+    // geometry can be built by jobs.
+    g.link_draw_items.resize(0);
+    for (int link_idx = editor.links.first_in_use(); link_idx != -1;
+         link_idx = editor.links.next_in_use(link_idx))
+    {
+        ImU32 link_color;
+        if (prepare_link(editor, link_idx, &link_color))
+        {
+            g.link_draw_items.push_back(LinkDrawItem(link_idx, link_color));
+        }
+    }
+
+    const bool links_drawn_by_jobs = run_draw_jobs(
+        editor,
+        g.link_draw_items.size(),
+        links_per_draw_job,
+        measure_link_job_item,
+        draw_link_job_item);
+    for (int i = 0; i < g.link_draw_items.size(); ++i)
+    {
+        if (!links_drawn_by_jobs || !splice_draw_job_item(i, links_per_draw_job))
         {
-            draw_link(editor, link_idx);
+            const LinkDrawItem& item = g.link_draw_items[i];
+            draw_link_geometry(
+                g.canvas_draw_list, g.link_points, editor, item.link_idx, item.color);
         }
     }
 
@@ -1692,15 +4399,11 @@ void EndNodeEditor()
     ImGui::PopStyleVar();   // pop frame padding
     ImGui::EndGroup();
 
-    for (int idx = 0; idx < editor.nodes.pool.size(); idx++)
-    {
-        NodeData& node = editor.nodes.pool[idx];
-        node.pin_indices.clear();
-    }
 }
 
-void BeginNode(const int node_id)
+bool BeginNode(const int node_id, const int flags)
 {
+    Context& g = *GImNodes;
     // Remember to call BeginNodeEditor before calling BeginNode
     assert(g.current_scope == Scope_Editor);
     g.current_scope = Scope_Node;
@@ -1712,58 +4415,220 @@ void BeginNode(const int node_id)
 
     NodeData& node = editor.nodes.pool[node_idx];
     node.id = node_id;
-    node.color_style.background = g.style.colors[ColorStyle_NodeBackground];
-    node.color_style.background_hovered = g.style.colors[ColorStyle_NodeBackgroundHovered];
-    node.color_style.background_selected = g.style.colors[ColorStyle_NodeBackgroundSelected];
-    node.color_style.outline = g.style.colors[ColorStyle_NodeOutline];
-    node.color_style.titlebar = g.style.colors[ColorStyle_TitleBar];
-    node.color_style.titlebar_hovered = g.style.colors[ColorStyle_TitleBarHovered];
-    node.color_style.titlebar_selected = g.style.colors[ColorStyle_TitleBarSelected];
-    node.layout_style.corner_rounding = g.style.node_corner_rounding;
-    node.layout_style.padding =
-        ImVec2(g.style.node_padding_horizontal, g.style.node_padding_vertical);
+    apply_current_node_style(node);
+
+    bool contents_hidden = false;
+    if ((flags & (NodeFlags_CullOffscreen | NodeFlags_Cacheable)) != 0 && node_has_layout(node))
+    {
+        // The node or the canvas may have moved since the node was last laid out.
+        const ImVec2 origin =
+            editor_space_to_screen_space(grid_space_to_editor_space(node.origin));
+        translate_node_layout(editor, node, origin - node.rect.Min);
+
+        if ((flags & NodeFlags_CullOffscreen) != 0 && !is_node_visible(node))
+        {
+            cull_node(editor, node_idx);
+            g.current_scope = Scope_Editor;
+            return false;
+        }
+
+        // The contents of a node which is too small to be drawn in full are skipped, except every
+        // few frames, when they are submitted hidden so that the node's layout follows them.
+        if (get_node_lod(node) != NodeLod_Full)
+        {
+            if (node.lod_skipped_frames < node_lod_max_skipped_frames)
+            {
+                ++node.lod_skipped_frames;
+                begin_node_without_channel();
+                submit_node_without_contents(editor, node_idx);
+                g.current_scope = Scope_Editor;
+                return false;
+            }
+            contents_hidden = true;
+        }
+
+        if ((flags & NodeFlags_Cacheable) != 0 && can_replay_node_content(node))
+        {
+            begin_node_channel();
+            submit_node_without_contents(editor, node_idx);
+            replay_node_content(node);
+            g.current_scope = Scope_Editor;
+            return false;
+        }
+    }
+
+    g.current_node_flags = flags;
+    g.current_node_contents_hidden = contents_hidden;
+    node.pin_indices.clear();
+    // Nodes which become too small together, e.g. nodes created during the same frame, start
+    // skipping their contents at different points of the refresh period. Otherwise all of their
+    // contents would be submitted during the same frame, once per period.
+    node.lod_skipped_frames = contents_hidden ? 0 : node_idx % node_lod_max_skipped_frames;
 
     // ImGui::SetCursorPos sets the cursor position, local to the current widget
     // (in this case, the child object started in BeginNodeEditor). Use
     // ImGui::SetCursorScreenPos to set the screen space coordinates directly.
     ImGui::SetCursorPos(grid_space_to_editor_space(get_node_title_bar_origin(node)));
 
-    g.canvas_draw_list->ChannelsSplit(Channels_Count);
-    g.canvas_draw_list->ChannelsSetCurrent(Channels_ImGui);
+    begin_node_channel();
+    g.current_node_first_vertex = g.canvas_draw_list->VtxBuffer.Size;
+    g.current_node_first_idx = g.canvas_draw_list->_VtxCurrentIdx;
 
     ImGui::PushID(node.id);
     ImGui::BeginGroup();
+    if (contents_hidden)
+    {
+        // No item overlaps this clip rectangle, so the items are laid out but not drawn.
+        ImGui::PushClipRect(ImVec2(-FLT_MAX, -FLT_MAX), ImVec2(-FLT_MAX, -FLT_MAX), false);
+    }
+    return true;
 }
 
 void EndNode()
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Node);
     g.current_scope = Scope_Editor;
 
     EditorContext& editor = editor_context_get();
 
+    if (g.current_node_contents_hidden)
+    {
+        ImGui::PopClipRect();
+    }
     // The node's rectangle depends on the ImGui UI group size.
     ImGui::EndGroup();
+    // The group is active when any of the node's items are active.
+    const bool content_active = ImGui::IsItemActive();
     ImGui::PopID();
     {
         NodeData& node = editor.nodes.pool[g.current_node_idx];
         node.rect = get_item_rect();
         node.rect.Expand(node.layout_style.padding);
+        node.content_active = content_active;
+
+        // Hidden contents would be recorded as nothing at all.
+        if ((g.current_node_flags & NodeFlags_Cacheable) != 0 && !g.current_node_contents_hidden)
+        {
+            // Don't record the node while its items might be drawn in their hovered or active
+            // state. An active item may also be changing the node's contents.
+            if (content_active)
+            {
+                node.content_snapshot.valid = false;
+            }
+            else if (!node.rect.Contains(ImGui::GetMousePos()))
+            {
+                record_node_content(node);
+            }
+        }
     }
 
-    g.canvas_draw_list->ChannelsSetCurrent(Channels_NodeBackground);
-    draw_node(editor, g.current_node_idx);
-    g.canvas_draw_list->ChannelsMerge();
+    submit_node(editor, g.current_node_idx);
+}
+
+void ProxyNode(
+    const int node_id,
+    const char* const title,
+    const ImVec2& size,
+    const ProxyPin* const pins,
+    const int num_pins)
+{
+    Context& g = *GImNodes;
+    assert(g.current_scope == Scope_Editor);
+    assert(num_pins == 0 || pins != NULL);
+
+    EditorContext& editor = editor_context_get();
+
+    const int node_idx = editor.nodes.find_or_create_index_for(node_id);
+    NodeData& node = editor.nodes.pool[node_idx];
+    node.id = node_id;
+    apply_current_node_style(node);
+
+    // Lay out the node the same way as BeginNode() would lay out a title bar with a single line
+    // of text, followed by one line of text per pin.
+    const ImVec2 origin = editor_space_to_screen_space(grid_space_to_editor_space(node.origin));
+    const ImVec2 padding = node.layout_style.padding;
+    node.rect = ImRect(origin, origin + size);
+
+    const float row_height = ImGui::GetTextLineHeight();
+    ImVec2 content_origin = origin + padding;
+    const bool has_title = title != NULL && title[0] != '\0';
+    if (has_title)
+    {
+        // The title bar spans the whole node, so there is no need to measure the title.
+        node.title_bar_content_rect = ImRect(
+            content_origin, ImVec2(node.rect.Max.x - padding.x, content_origin.y + row_height));
+        content_origin.y += row_height + 2.f * padding.y;
+    }
+    else
+    {
+        node.title_bar_content_rect = ImRect(content_origin, content_origin);
+    }
+
+    const float row_stride = ImGui::GetTextLineHeightWithSpacing();
+    float input_row_y = content_origin.y;
+    float output_row_y = content_origin.y;
+
+    node.pin_indices.clear();
+    for (int i = 0; i < num_pins; ++i)
+    {
+        const ProxyPin& proxy_pin = pins[i];
+        const int pin_idx = editor.pins.find_or_create_index_for(proxy_pin.id);
+        PinData& pin = editor.pins.pool[pin_idx];
+        apply_current_pin_style(
+            pin,
+            proxy_pin.id,
+            proxy_pin.output ? AttributeType_Output : AttributeType_Input,
+            proxy_pin.shape,
+            node_idx);
+
+        float& row_y = proxy_pin.output ? output_row_y : input_row_y;
+        pin.attribute_rect = ImRect(
+            ImVec2(content_origin.x, row_y),
+            ImVec2(node.rect.Max.x - padding.x, row_y + row_height));
+        row_y += row_stride;
+
+        node.pin_indices.push_back(pin_idx);
+    }
+
+    // A proxy node has no contents which would have to be submitted, so it can always be culled.
+    if (!is_node_visible(node))
+    {
+        cull_node(editor, node_idx);
+        return;
+    }
+
+    if (has_title && get_node_lod(node) == NodeLod_Full)
+    {
+        begin_node_channel();
+        const ImVec4 clip_rect(node.rect.Min.x, node.rect.Min.y, node.rect.Max.x, node.rect.Max.y);
+        g.canvas_draw_list->AddText(
+            ImGui::GetFont(),
+            ImGui::GetFontSize(),
+            node.title_bar_content_rect.Min,
+            ImGui::GetColorU32(ImGuiCol_Text),
+            title,
+            NULL,
+            0.f,
+            &clip_rect);
+    }
+    else
+    {
+        begin_node_without_channel();
+    }
+
+    submit_node(editor, node_idx);
 }
 
 void BeginNodeTitleBar()
 {
-    assert(g.current_scope == Scope_Node);
+    assert(GImNodes->current_scope == Scope_Node);
     ImGui::BeginGroup();
 }
 
 void EndNodeTitleBar()
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Node);
     ImGui::EndGroup();
 
@@ -1778,6 +4643,7 @@ void EndNodeTitleBar()
 
 void BeginInputAttribute(const int id, const PinShape shape)
 {
+    Context& g = *GImNodes;
     begin_pin_attribute(id, AttributeType_Input, shape, g.current_node_idx);
 }
 
@@ -1785,6 +4651,7 @@ void EndInputAttribute() { end_pin_attribute(); }
 
 void BeginOutputAttribute(const int id, const PinShape shape)
 {
+    Context& g = *GImNodes;
     begin_pin_attribute(id, AttributeType_Output, shape, g.current_node_idx);
 }
 
@@ -1792,6 +4659,7 @@ void EndOutputAttribute() { end_pin_attribute(); }
 
 void BeginStaticAttribute(const int id)
 {
+    Context& g = *GImNodes;
     // Make sure to call BeginNode() before calling BeginAttribute()
     assert(g.current_scope == Scope_Node);
     g.current_scope = Scope_Attribute;
@@ -1804,6 +4672,7 @@ void BeginStaticAttribute(const int id)
 
 void EndStaticAttribute()
 {
+    Context& g = *GImNodes;
     // Make sure to call BeginNode() before calling BeginAttribute()
     assert(g.current_scope == Scope_Attribute);
     g.current_scope = Scope_Node;
@@ -1820,6 +4689,7 @@ void EndStaticAttribute()
 
 void EndAttribute()
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Attribute);
     g.current_scope = Scope_Node;
 
@@ -1848,12 +4718,14 @@ void EndAttribute()
 
 void PushAttributeFlag(AttributeFlags flag)
 {
+    Context& g = *GImNodes;
     g.current_attribute_flags |= static_cast<int>(flag);
     g.attribute_flag_stack.push_back(g.current_attribute_flags);
 }
 
 void PopAttributeFlag()
 {
+    Context& g = *GImNodes;
     // PopAttributeFlag called without a matching PushAttributeFlag!
     // The bottom value is always the default value, pushed in Initialize().
     assert(g.attribute_flag_stack.size() > 1);
@@ -1864,13 +4736,16 @@ void PopAttributeFlag()
 
 void Link(int id, const int start_attr_id, const int end_attr_id)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_Editor);
 
     EditorContext& editor = editor_context_get();
-    LinkData& link = editor.links.find_or_create_new(id);
+    const int link_idx = editor.links.find_or_create_index_for(id);
+    LinkData& link = editor.links.pool[link_idx];
     link.id = id;
     link.start_pin_idx = editor.pins.find_or_create_index_for(start_attr_id);
     link.end_pin_idx = editor.pins.find_or_create_index_for(end_attr_id);
+    editor.link_pin_pairs.insert(make_pin_pair_key(link.start_pin_idx, link.end_pin_idx), link_idx);
     link.color_style.base = g.style.colors[ColorStyle_Link];
     link.color_style.hovered = g.style.colors[ColorStyle_LinkHovered];
     link.color_style.selected = g.style.colors[ColorStyle_LinkSelected];
@@ -1883,20 +4758,35 @@ void Link(int id, const int start_attr_id, const int end_attr_id)
         (editor.click_interaction_state.link_creation.start_pin_idx == link.end_pin_idx &&
          editor.click_interaction_state.link_creation.end_pin_idx == link.start_pin_idx))
     {
-        g.snap_link_idx = editor.links.find_or_create_index_for(id);
+        g.snap_link_idx = link_idx;
+    }
+}
+
+bool HasLink(const int start_attr_id, const int end_attr_id)
+{
+    const EditorContext& editor = editor_context_get();
+    const int start_pin_idx = editor.pins.id_map.find(start_attr_id);
+    const int end_pin_idx = editor.pins.id_map.find(end_attr_id);
+    if (start_pin_idx == -1 || end_pin_idx == -1)
+    {
+        return false;
     }
+
+    return editor.link_pin_pairs.find(make_pin_pair_key(start_pin_idx, end_pin_idx)) != -1;
 }
 
 void PushColorStyle(ColorStyle item, unsigned int color)
 {
+    Context& g = *GImNodes;
     // Remember to call Initialize() before using any other functions!
-    assert(initialized);
+    assert(GImNodes != NULL);
     g.color_modifier_stack.push_back(ColorStyleElement(g.style.colors[item], item));
     g.style.colors[item] = color;
 }
 
 void PopColorStyle()
 {
+    Context& g = *GImNodes;
     assert(g.color_modifier_stack.size() > 0);
     const ColorStyleElement elem = g.color_modifier_stack.back();
     g.style.colors[elem.item] = elem.color;
@@ -1905,6 +4795,7 @@ void PopColorStyle()
 
 float& lookup_style_var(const StyleVar item)
 {
+    Context& g = *GImNodes;
     // TODO: once the switch gets too big and unwieldy to work with, we could do
     // a byte-offset lookup into the Style struct, using the StyleVar as an
     // index. This is how ImGui does it.
@@ -1932,6 +4823,7 @@ float& lookup_style_var(const StyleVar item)
 
 void PushStyleVar(const StyleVar item, const float value)
 {
+    Context& g = *GImNodes;
     float& style_var = lookup_style_var(item);
     g.style_modifier_stack.push_back(StyleElement(style_var, item));
     style_var = value;
@@ -1939,6 +4831,7 @@ void PushStyleVar(const StyleVar item, const float value)
 
 void PopStyleVar()
 {
+    Context& g = *GImNodes;
     assert(g.style_modifier_stack.size() > 0);
     const StyleElement style_elem = g.style_modifier_stack.back();
     g.style_modifier_stack.pop_back();
@@ -1949,7 +4842,7 @@ void PopStyleVar()
 void SetNodeScreenSpacePos(int node_id, const ImVec2& screen_space_pos)
 {
     // Remember to call Initialize() before using any other functions!
-    assert(initialized);
+    assert(GImNodes != NULL);
     EditorContext& editor = editor_context_get();
     NodeData& node = editor.nodes.find_or_create_new(node_id);
     node.origin = screen_space_to_grid_space(screen_space_pos);
@@ -1958,7 +4851,7 @@ void SetNodeScreenSpacePos(int node_id, const ImVec2& screen_space_pos)
 void SetNodeGridSpacePos(int node_id, const ImVec2& grid_pos)
 {
     // Remember to call Initialize() before using any other functions!
-    assert(initialized);
+    assert(GImNodes != NULL);
     EditorContext& editor = editor_context_get();
     NodeData& node = editor.nodes.find_or_create_new(node_id);
     node.origin = grid_pos;
@@ -1966,19 +4859,34 @@ void SetNodeGridSpacePos(int node_id, const ImVec2& grid_pos)
 
 void SetNodeDraggable(int node_id, const bool draggable)
 {
-    assert(initialized);
+    assert(GImNodes != NULL);
     EditorContext& editor = editor_context_get();
     NodeData& node = editor.nodes.find_or_create_new(node_id);
     node.draggable = draggable;
 }
 
+void InvalidateNode(const int node_id)
+{
+    assert(GImNodes != NULL);
+    EditorContext& editor = editor_context_get();
+    const int node_idx = editor.nodes.id_map.find(node_id);
+    if (node_idx != -1)
+    {
+        NodeData& node = editor.nodes.pool[node_idx];
+        node.content_snapshot.valid = false;
+        node.lod_skipped_frames = node_lod_max_skipped_frames;
+    }
+}
+
 bool IsEditorHovered()
 {
+    Context& g = *GImNodes;
     return g.canvas_rect_screen_space.Contains(ImGui::GetMousePos()) && ImGui::IsWindowHovered();
 }
 
 bool IsNodeHovered(int* const node_id)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_None);
     assert(node_id != NULL);
 
@@ -1993,6 +4901,7 @@ bool IsNodeHovered(int* const node_id)
 
 bool IsLinkHovered(int* const link_id)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_None);
     assert(link_id != NULL);
 
@@ -2007,6 +4916,7 @@ bool IsLinkHovered(int* const link_id)
 
 bool IsPinHovered(int* const attr)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_None);
     assert(attr != NULL);
 
@@ -2021,14 +4931,14 @@ bool IsPinHovered(int* const attr)
 
 int NumSelectedNodes()
 {
-    assert(g.current_scope == Scope_None);
+    assert(GImNodes->current_scope == Scope_None);
     const EditorContext& editor = editor_context_get();
     return editor.selected_node_indices.size();
 }
 
 int NumSelectedLinks()
 {
-    assert(g.current_scope == Scope_None);
+    assert(GImNodes->current_scope == Scope_None);
     const EditorContext& editor = editor_context_get();
     return editor.selected_link_indices.size();
 }
@@ -2059,6 +4969,7 @@ void GetSelectedLinks(int* link_ids)
 
 bool IsAttributeActive()
 {
+    Context& g = *GImNodes;
     assert((g.current_scope & Scope_Node) != 0);
 
     if (!g.active_attribute)
@@ -2071,6 +4982,7 @@ bool IsAttributeActive()
 
 bool IsAnyAttributeActive(int* const attribute_id)
 {
+    Context& g = *GImNodes;
     assert((g.current_scope & (Scope_Node | Scope_Attribute)) == 0);
 
     if (!g.active_attribute)
@@ -2088,6 +5000,7 @@ bool IsAnyAttributeActive(int* const attribute_id)
 
 bool IsLinkStarted(int* const started_at_id)
 {
+    Context& g = *GImNodes;
     // Call this function after EndNodeEditor()!
     assert(g.current_scope == Scope_None);
     assert(started_at_id != NULL);
@@ -2105,6 +5018,7 @@ bool IsLinkStarted(int* const started_at_id)
 
 bool IsLinkDropped(int* const started_at_id, const bool including_detached_links)
 {
+    Context& g = *GImNodes;
     // Call this function after EndNodeEditor()!
     assert(g.current_scope == Scope_None);
 
@@ -2129,6 +5043,7 @@ bool IsLinkCreated(
     int* const ended_at_pin_id,
     bool* const created_from_snap)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_None);
     assert(started_at_pin_id != NULL);
     assert(ended_at_pin_id != NULL);
@@ -2154,6 +5069,7 @@ bool IsLinkCreated(
 
 bool IsLinkDestroyed(int* const link_id)
 {
+    Context& g = *GImNodes;
     assert(g.current_scope == Scope_None);
 
     const bool link_destroyed = g.deleted_link_idx.has_value();
@@ -2169,28 +5085,351 @@ bool IsLinkDestroyed(int* const link_id)
 
 namespace
 {
-void node_line_handler(EditorContext& editor, const char* line)
+inline bool is_ini_space(const char c) { return c == ' ' || c == '\t'; }
+
+// Returns the value of the digit c, or 16 if c isn't a hexadecimal digit.
+inline unsigned int ini_digit_value(const char c)
 {
-    int id;
+    if (c >= '0' && c <= '9')
+    {
+        return (unsigned int)(c - '0');
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return (unsigned int)(c - 'a' + 10);
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return (unsigned int)(c - 'A' + 10);
+    }
+    return 16u;
+}
+
+// Returns the end of prefix, if [p, end) starts with it, or NULL.
+inline const char* match_ini_prefix(const char* p, const char* const end, const char* prefix)
+{
+    for (; *prefix != '\0'; ++prefix, ++p)
+    {
+        if (p == end || *p != *prefix)
+        {
+            return NULL;
+        }
+    }
+    return p;
+}
+
+// Parses an integer at the start of [p, end) like sscanf's %i: an optional sign, followed by a
+// decimal, octal (leading 0) or hexadecimal (leading 0x) number. Returns the end of the number,
+// or NULL if there is no number.
+const char* parse_ini_int(const char* p, const char* const end, int* const value)
+{
+    while (p < end && is_ini_space(*p))
+    {
+        ++p;
+    }
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    unsigned int base = 10u;
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') &&
+        ini_digit_value(p[2]) < 16u)
+    {
+        base = 16u;
+        p += 2;
+    }
+    else if (p < end && *p == '0')
+    {
+        base = 8u;
+    }
+
+    const char* const digits = p;
+    ImU32 magnitude = 0u;
+    for (unsigned int digit; p < end && (digit = ini_digit_value(*p)) < base; ++p)
+    {
+        magnitude = magnitude * base + digit;
+    }
+    if (p == digits)
+    {
+        return NULL;
+    }
+    *value = (int)(negative ? 0u - magnitude : magnitude);
+    return p;
+}
+
+// Parses a floating point number at the start of [p, end) like sscanf's %f, and rounds it to the
+// same float as strtof. Returns the end of the number, or NULL if there is no number.
+const char* parse_ini_float(const char* p, const char* const end, float* const value)
+{
+    // Powers of ten which are exactly representable as floats.
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10};
+    const ImU64 max_float_mantissa = 1u << 24;
+
+    while (p < end && is_ini_space(*p))
+    {
+        ++p;
+    }
+    const char* const number = p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // Gather the significant digits into an integer. The count of significant digits guards
+    // against the integer overflowing.
+    ImU64 mantissa = 0u;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        mantissa = mantissa * 10u + (ImU64)(*p - '0');
+        significant_digits += mantissa != 0u;
+        has_digits = true;
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            mantissa = mantissa * 10u + (ImU64)(*p - '0');
+            significant_digits += mantissa != 0u;
+            exponent--;
+            has_digits = true;
+        }
+    }
+    if (has_digits && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponent_digits = p + 1;
+        bool negative_exponent = false;
+        if (exponent_digits < end && (*exponent_digits == '+' || *exponent_digits == '-'))
+        {
+            negative_exponent = *exponent_digits == '-';
+            ++exponent_digits;
+        }
+        if (exponent_digits < end && *exponent_digits >= '0' && *exponent_digits <= '9')
+        {
+            int written_exponent = 0;
+            for (p = exponent_digits; p < end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (written_exponent < 10000)
+                {
+                    written_exponent = written_exponent * 10 + (*p - '0');
+                }
+            }
+            exponent += negative_exponent ? -written_exponent : written_exponent;
+        }
+    }
+
+    // When both the integer and the power of ten are exactly representable as floats, which is
+    // the case for everything written by the save functions, the number is converted with a single
+    // multiplication or division. Double precision is more than twice float precision, so rounding
+    // the double result to a float gives the correctly rounded float, like strtof does. Everything
+    // else, such as long numbers, infinities and hexadecimal floats, is left to strtof.
+    const bool hexadecimal = p < end && (*p == 'x' || *p == 'X');
+    if (!has_digits || hexadecimal || significant_digits > 15 || mantissa > max_float_mantissa ||
+        exponent < -10 || exponent > 10)
+    {
+        char buffer[64];
+        const size_t length = ImMin((size_t)(end - number), sizeof(buffer) - 1);
+        memcpy(buffer, number, length);
+        buffer[length] = '\0';
+        char* buffer_end = buffer;
+        const float parsed = strtof(buffer, &buffer_end);
+        if (buffer_end == buffer)
+        {
+            return NULL;
+        }
+        *value = parsed;
+        return number + (buffer_end - buffer);
+    }
+
+    double magnitude = (double)mantissa;
+    magnitude = exponent < 0 ? magnitude / powers_of_ten[-exponent]
+                             : magnitude * powers_of_ten[exponent];
+    *value = (float)(negative ? -magnitude : magnitude);
+    return p;
+}
+
+// Parses a "key=x,y" line.
+bool parse_ini_vec2(
+    const char* const line,
+    const char* const line_end,
+    const char* const key,
+    ImVec2* const value)
+{
+    const char* p = match_ini_prefix(line, line_end, key);
     float x, y;
-    if (sscanf(line, "[node.%i", &id) == 1)
+    if (p == NULL || (p = parse_ini_float(p, line_end, &x)) == NULL ||
+        (p = match_ini_prefix(p, line_end, ",")) == NULL ||
+        parse_ini_float(p, line_end, &y) == NULL)
     {
-        const int node_idx = editor.nodes.find_or_create_index_for(id);
-        g.current_node_idx = node_idx;
-        NodeData& node = editor.nodes.pool[node_idx];
-        node.id = id;
+        return false;
     }
-    else if (sscanf(line, "origin=%f,%f", &x, &y) == 2)
+    *value = ImVec2(x, y);
+    return true;
+}
+
+void ini_load_line(IniLoadState& state, const char* const line, const char* line_end)
+{
+    while (line_end > line && is_ini_space(line_end[-1]))
     {
-        NodeData& node = editor.nodes.pool[g.current_node_idx];
-        node.origin = ImVec2(x, y);
+        --line_end;
+    }
+    if (line == line_end || *line == ';')
+    {
+        return;
+    }
+
+    EditorContext& editor = *state.editor;
+    if (line[0] == '[' && line_end[-1] == ']')
+    {
+        const char* const name_end = line_end - 1;
+        const char* p = match_ini_prefix(line + 1, name_end, "node");
+        if (p != NULL)
+        {
+            state.section = IniSection_Node;
+            state.node_idx = -1;
+            int id;
+            if ((p = match_ini_prefix(p, name_end, ".")) != NULL &&
+                parse_ini_int(p, name_end, &id) != NULL)
+            {
+                state.node_idx = editor.nodes.find_or_create_index_for(id);
+            }
+        }
+        else if (match_ini_prefix(line + 1, name_end, "editor") == name_end)
+        {
+            state.section = IniSection_Editor;
+        }
+        else
+        {
+            state.section = IniSection_None;
+        }
+        return;
+    }
+
+    switch (state.section)
+    {
+    case IniSection_Editor:
+        parse_ini_vec2(line, line_end, "panning=", &editor.panning);
+        break;
+    case IniSection_Node:
+        if (state.node_idx != -1)
+        {
+            parse_ini_vec2(line, line_end, "origin=", &editor.nodes.pool[state.node_idx].origin);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+inline const char* find_ini_line_end(const char* p, const char* const end)
+{
+    while (p < end && *p != '\n' && *p != '\r')
+    {
+        ++p;
+    }
+    return p;
+}
+
+// Each node has a section of its own, so the number of sections bounds the number of nodes which
+// loading the data creates.
+int count_ini_sections(const char* const data, const char* const data_end)
+{
+    int section_count = 0;
+    for (const char* p = data;
+         p < data_end && (p = (const char*)memchr(p, '[', data_end - p)) != NULL;
+         ++p)
+    {
+        section_count++;
+    }
+    return section_count;
+}
+
+// Makes room in the node pool for the nodes of a chunk. The pool grows to at least twice its
+// capacity, so that a load which is split into many chunks doesn't grow it repeatedly.
+void reserve_ini_chunk_nodes(
+    ObjectPool<NodeData>& nodes,
+    const char* const data,
+    const char* const data_end)
+{
+    const int node_count = nodes.pool.size() + count_ini_sections(data, data_end);
+    if (node_count > nodes.pool.Capacity)
+    {
+        nodes.reserve(ImMax(2 * nodes.pool.Capacity, node_count));
     }
 }
 
-void editor_line_handler(EditorContext& editor, const char* line)
+// Loads the lines in [data, data_end). Unless this is the last chunk, a line which reaches the end
+// of the chunk may continue in the next one, and is kept in state.partial_line until it does.
+void ini_load_chunk(
+    IniLoadState& state,
+    const char* data,
+    const char* const data_end,
+    const bool last_chunk)
 {
-    sscanf(line, "panning=%f,%f", &editor.panning.x, &editor.panning.y);
+    if (!state.partial_line.empty())
+    {
+        const char* const line_end = find_ini_line_end(data, data_end);
+        if (line_end != data)
+        {
+            state.partial_line.append(data, line_end);
+        }
+        if (line_end == data_end && !last_chunk)
+        {
+            return;
+        }
+        ini_load_line(state, state.partial_line.begin(), state.partial_line.end());
+        state.partial_line.clear();
+        data = line_end;
+    }
+
+    while (data < data_end)
+    {
+        if (*data == '\n' || *data == '\r')
+        {
+            ++data;
+            continue;
+        }
+        const char* const line_end = find_ini_line_end(data, data_end);
+        if (line_end == data_end && !last_chunk)
+        {
+            state.partial_line.append(data, line_end);
+            return;
+        }
+        ini_load_line(state, data, line_end);
+        data = line_end;
+    }
 }
+
+// The binary editor state starts with this header. It's followed by node_count node records, and
+// then by the ids of the selected_node_count selected nodes.
+struct BinaryStateHeader
+{
+    char magic[4];
+    ImU32 version;
+    ImU32 node_count;
+    ImU32 selected_node_count;
+    ImVec2 panning;
+};
+
+struct BinaryNodeRecord
+{
+    ImS32 id;
+    ImVec2 origin;
+};
+
+// The records are packed without padding, and read in place.
+IM_STATIC_ASSERT(sizeof(BinaryStateHeader) == 24 && sizeof(BinaryNodeRecord) == 12);
+
+const char binary_state_magic[4] = {'I', 'M', 'N', 'B'};
+// Increment the version whenever the layout of the binary state changes.
+const ImU32 binary_state_version = 1u;
 } // namespace
 
 const char* SaveCurrentEditorStateToIniString(size_t* const data_size)
@@ -2202,6 +5441,7 @@ const char* SaveEditorStateToIniString(
     const EditorContext* const editor_ptr,
     size_t* const data_size)
 {
+    Context& g = *GImNodes;
     assert(editor_ptr != NULL);
     const EditorContext& editor = *editor_ptr;
 
@@ -2212,14 +5452,11 @@ const char* SaveEditorStateToIniString(
     g.text_buffer.appendf(
         "[editor]\npanning=%i,%i\n", (int)editor.panning.x, (int)editor.panning.y);
 
-    for (int i = 0; i < editor.nodes.pool.size(); i++)
+    for (int i = editor.nodes.first_in_use(); i != -1; i = editor.nodes.next_in_use(i))
     {
-        if (editor.nodes.in_use[i])
-        {
-            const NodeData& node = editor.nodes.pool[i];
-            g.text_buffer.appendf("\n[node.%d]\n", node.id);
-            g.text_buffer.appendf("origin=%i,%i\n", (int)node.origin.x, (int)node.origin.y);
-        }
+        const NodeData& node = editor.nodes.pool[i];
+        g.text_buffer.appendf("\n[node.%d]\n", node.id);
+        g.text_buffer.appendf("origin=%i,%i\n", (int)node.origin.x, (int)node.origin.y);
     }
 
     if (data_size != NULL)
@@ -2245,53 +5482,47 @@ void LoadEditorStateFromIniString(
         return;
     }
 
-    EditorContext& editor = editor_ptr == NULL ? editor_context_get() : *editor_ptr;
+    IniLoadState state;
+    state.editor = editor_ptr == NULL ? &editor_context_get() : editor_ptr;
 
-    char* buf = (char*)ImGui::MemAlloc(data_size + 1);
-    const char* buf_end = buf + data_size;
-    memcpy(buf, data, data_size);
-    buf[data_size] = 0;
+    // Reserve the nodes up front, rather than growing the node pool repeatedly. The editor's
+    // existing nodes are most likely the ones being loaded.
+    const char* const data_end = data + data_size;
+    ObjectPool<NodeData>& nodes = state.editor->nodes;
+    nodes.reserve(ImMax(nodes.pool.size(), count_ini_sections(data, data_end)));
+    ini_load_chunk(state, data, data_end, true);
+}
 
-    void (*line_handler)(EditorContext&, const char*);
-    line_handler = NULL;
-    char* line_end = NULL;
-    for (char* line = buf; line < buf_end; line = line_end + 1)
-    {
-        while (*line == '\n' || *line == '\r')
-        {
-            line++;
-        }
-        line_end = line;
-        while (line_end < buf_end && *line_end != '\n' && *line_end != '\r')
-        {
-            line_end++;
-        }
-        line_end[0] = 0;
+void BeginLoadCurrentEditorStateFromIni() { BeginLoadEditorStateFromIni(&editor_context_get()); }
 
-        if (*line == ';' || *line == '\0')
-        {
-            continue;
-        }
+void BeginLoadEditorStateFromIni(EditorContext* const editor)
+{
+    Context& g = *GImNodes;
+    assert(editor != NULL);
+    // Did you forget to call EndLoadEditorStateFromIni()?
+    assert(g.ini_load.editor == NULL);
+    g.ini_load.editor = editor;
+    g.ini_load.section = IniSection_None;
+    g.ini_load.node_idx = -1;
+    g.ini_load.partial_line.clear();
+}
 
-        if (line[0] == '[' && line_end[-1] == ']')
-        {
-            line_end[-1] = 0;
-            if (strncmp(line + 1, "node", 4) == 0)
-            {
-                line_handler = node_line_handler;
-            }
-            else if (strcmp(line + 1, "editor") == 0)
-            {
-                line_handler = editor_line_handler;
-            }
-        }
+void LoadEditorStateFromIniChunk(const char* const data, const size_t data_size)
+{
+    Context& g = *GImNodes;
+    // Remember to call BeginLoadEditorStateFromIni() first!
+    assert(g.ini_load.editor != NULL);
+    reserve_ini_chunk_nodes(g.ini_load.editor->nodes, data, data + data_size);
+    ini_load_chunk(g.ini_load, data, data + data_size, false);
+}
 
-        if (line_handler != NULL)
-        {
-            line_handler(editor, line);
-        }
-    }
-    ImGui::MemFree(buf);
+void EndLoadEditorStateFromIni()
+{
+    Context& g = *GImNodes;
+    assert(g.ini_load.editor != NULL);
+    ini_load_chunk(g.ini_load, NULL, NULL, true);
+    g.ini_load.editor = NULL;
+    g.ini_load.partial_line.clear();
 }
 
 void SaveCurrentEditorStateToIniFile(const char* const file_name)
@@ -2319,16 +5550,191 @@ void LoadCurrentEditorStateFromIniFile(const char* const file_name)
 }
 
 void LoadEditorStateFromIniFile(EditorContext* const editor, const char* const file_name)
+{
+    FILE* file = ImFileOpen(file_name, "rb");
+    if (!file)
+    {
+        return;
+    }
+
+    // The file is loaded in chunks, so that it never has to be held in memory all at once.
+    IniLoadState state;
+    state.editor = editor == NULL ? &editor_context_get() : editor;
+    char chunk[4096];
+    size_t chunk_size;
+    while ((chunk_size = fread(chunk, sizeof(char), sizeof(chunk), file)) > 0u)
+    {
+        reserve_ini_chunk_nodes(state.editor->nodes, chunk, chunk + chunk_size);
+        ini_load_chunk(state, chunk, chunk + chunk_size, false);
+    }
+    ini_load_chunk(state, NULL, NULL, true);
+    fclose(file);
+}
+
+const void* SaveCurrentEditorStateToBinary(size_t* const data_size)
+{
+    return SaveEditorStateToBinary(&editor_context_get(), data_size);
+}
+
+const void* SaveEditorStateToBinary(const EditorContext* const editor_ptr, size_t* const data_size)
+{
+    Context& g = *GImNodes;
+    assert(editor_ptr != NULL);
+    const EditorContext& editor = *editor_ptr;
+
+    BinaryStateHeader header;
+    memcpy(header.magic, binary_state_magic, sizeof(header.magic));
+    header.version = binary_state_version;
+    header.node_count = 0u;
+    header.selected_node_count = 0u;
+    header.panning = editor.panning;
+
+    for (int i = editor.nodes.first_in_use(); i != -1; i = editor.nodes.next_in_use(i))
+    {
+        header.node_count++;
+    }
+    for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+    {
+        if (editor.nodes.is_in_use(editor.selected_node_indices[i]))
+        {
+            header.selected_node_count++;
+        }
+    }
+
+    g.binary_buffer.resize(
+        sizeof(BinaryStateHeader) + header.node_count * sizeof(BinaryNodeRecord) +
+        header.selected_node_count * sizeof(ImS32));
+    char* out = g.binary_buffer.Data;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (int i = editor.nodes.first_in_use(); i != -1; i = editor.nodes.next_in_use(i))
+    {
+        const NodeData& node = editor.nodes.pool[i];
+        BinaryNodeRecord record;
+        record.id = node.id;
+        record.origin = node.origin;
+        memcpy(out, &record, sizeof(record));
+        out += sizeof(record);
+    }
+
+    for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+    {
+        const int node_idx = editor.selected_node_indices[i];
+        if (editor.nodes.is_in_use(node_idx))
+        {
+            const ImS32 id = editor.nodes.pool[node_idx].id;
+            memcpy(out, &id, sizeof(id));
+            out += sizeof(id);
+        }
+    }
+
+    if (data_size != NULL)
+    {
+        *data_size = g.binary_buffer.size();
+    }
+
+    return g.binary_buffer.Data;
+}
+
+bool LoadCurrentEditorStateFromBinary(const void* const data, const size_t data_size)
+{
+    return LoadEditorStateFromBinary(&editor_context_get(), data, data_size);
+}
+
+bool LoadEditorStateFromBinary(
+    EditorContext* const editor_ptr,
+    const void* const data,
+    const size_t data_size)
+{
+    BinaryStateHeader header;
+    if (data == NULL || data_size < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, binary_state_magic, sizeof(header.magic)) != 0 ||
+        header.version != binary_state_version)
+    {
+        return false;
+    }
+
+    // Check that the records fit in the data before touching the editor.
+    const size_t records_size = data_size - sizeof(header);
+    if (header.node_count > (ImU32)INT_MAX ||
+        header.node_count > records_size / sizeof(BinaryNodeRecord) ||
+        header.selected_node_count >
+            (records_size - header.node_count * sizeof(BinaryNodeRecord)) / sizeof(ImS32))
+    {
+        return false;
+    }
+
+    EditorContext& editor = editor_ptr == NULL ? editor_context_get() : *editor_ptr;
+    editor.panning = header.panning;
+
+    const char* in = static_cast<const char*>(data) + sizeof(header);
+    editor.nodes.reserve(editor.nodes.pool.size() + (int)header.node_count);
+    for (ImU32 i = 0u; i < header.node_count; ++i)
+    {
+        BinaryNodeRecord record;
+        memcpy(&record, in, sizeof(record));
+        in += sizeof(record);
+        editor.nodes.find_or_create_new(record.id).origin = record.origin;
+    }
+
+    editor.selected_node_indices.clear();
+    for (ImU32 i = 0u; i < header.selected_node_count; ++i)
+    {
+        ImS32 id;
+        memcpy(&id, in, sizeof(id));
+        in += sizeof(id);
+        const int node_idx = editor.nodes.id_map.find(id);
+        if (node_idx != -1 && !editor.selected_node_indices.contains(node_idx))
+        {
+            editor.selected_node_indices.push_back(node_idx);
+        }
+    }
+
+    return true;
+}
+
+void SaveCurrentEditorStateToBinaryFile(const char* const file_name)
+{
+    SaveEditorStateToBinaryFile(&editor_context_get(), file_name);
+}
+
+void SaveEditorStateToBinaryFile(const EditorContext* const editor, const char* const file_name)
+{
+    size_t data_size = 0u;
+    const void* data = SaveEditorStateToBinary(editor, &data_size);
+    FILE* file = ImFileOpen(file_name, "wb");
+    if (!file)
+    {
+        return;
+    }
+
+    fwrite(data, 1, data_size, file);
+    fclose(file);
+}
+
+bool LoadCurrentEditorStateFromBinaryFile(const char* const file_name)
+{
+    return LoadEditorStateFromBinaryFile(&editor_context_get(), file_name);
+}
+
+bool LoadEditorStateFromBinaryFile(EditorContext* const editor, const char* const file_name)
 {
     size_t data_size = 0u;
-    char* file_data = (char*)ImFileLoadToMemory(file_name, "rb", &data_size);
+    void* file_data = ImFileLoadToMemory(file_name, "rb", &data_size);
 
     if (!file_data)
     {
-        return;
+        return false;
     }
 
-    LoadEditorStateFromIniString(editor, file_data, data_size);
+    const bool loaded = LoadEditorStateFromBinary(editor, file_data, data_size);
     ImGui::MemFree(file_data);
+    return loaded;
 }
 } // namespace imnodes
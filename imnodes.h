@@ -48,7 +48,10 @@ enum StyleFlags
 {
     StyleFlags_None = 0,
     StyleFlags_NodeOutline = 1 << 0,
-    StyleFlags_GridLines = 1 << 2
+    StyleFlags_GridLines = 1 << 2,
+    // Flatten links by subdividing each curve until it is within Style::link_flattening_tolerance
+    // of its polyline, instead of using a segment count proportional to the link's length.
+    StyleFlags_AdaptiveLinkFlattening = 1 << 3
 };
 
 // This enum controls the way attribute pins look.
@@ -78,6 +81,29 @@ enum AttributeFlags
     AttributeFlags_EnableLinkCreationOnSnap = 1 << 1
 };
 
+// This enum controls the way a node is submitted with BeginNode().
+enum NodeFlags
+{
+    NodeFlags_None = 0,
+    // Skip nodes which lie outside of the editor canvas. The visibility test uses the node's
+    // rectangle from the previous frame, so a node is always submitted at least once. BeginNode()
+    // returns false for a culled node, in which case the node's contents must not be submitted and
+    // EndNode() must not be called. The pins of a culled node stay alive, so links connected to it
+    // are still rendered.
+    NodeFlags_CullOffscreen = 1 << 0,
+    // Record the node's ImGui output, and replay it on later frames instead of submitting the
+    // node's contents. BeginNode() returns false when the recording is replayed, in which case the
+    // node's contents must not be submitted and EndNode() must not be called. The node is
+    // submitted normally while the mouse is over it or one of its items is active, and it's only
+    // recorded while it lies entirely within the canvas, so combine this flag with
+    // NodeFlags_CullOffscreen. Call InvalidateNode() when the node's contents change.
+    NodeFlags_Cacheable = 1 << 1
+};
+
+// A unit of work handed to IO::JobDispatch. The function is called once for each job_index in
+// [0, job_count), with the job_data passed to the dispatch function.
+typedef void (*JobFunction)(void* job_data, int job_index);
+
 struct IO
 {
     struct EmulateThreeButtonMouse
@@ -104,6 +130,35 @@ struct IO
         const bool* modifier;
     } link_detach_with_modifier_click;
 
+    struct JobDispatch
+    {
+        JobDispatch();
+
+        // Runs job(job_data, i) for each i in [0, job_count), in any order and on any thread, and
+        // returns once all of the jobs have finished. Set to NULL by default, in which case all of
+        // the work is done on the calling thread.
+        //
+        // When set, EndNodeEditor() splits the tessellation of large numbers of links and nodes
+        // into jobs. Each job builds its geometry into a draw list of its own, which is then copied
+        // into the editor's draw list in the same order as if it had been drawn serially. The
+        // overlap tests of box selection are split into jobs as well, and their results are
+        // collected in the same order. Hovering is still resolved on the calling thread. The jobs
+        // don't call ImGui, and don't allocate memory: the calling thread reserves the jobs' draw
+        // lists before dispatching them, because ImGui::MemAlloc() updates ImGui's allocation
+        // counter without synchronization.
+        void (*dispatch)(JobFunction job, void* job_data, int job_count, void* user_data);
+        // Passed to dispatch as user_data, e.g. a pointer to the application's thread pool.
+        void* user_data;
+    } job_dispatch;
+
+    // The following metrics are updated by the node editor during each frame, and can be read after
+    // EndNodeEditor() has been called.
+
+    // The number of links which were rendered.
+    int metrics_rendered_links;
+    // The number of links which were skipped, because they were outside of the editor canvas.
+    int metrics_culled_links;
+
     IO();
 };
 
@@ -118,6 +173,9 @@ struct Style
     float link_thickness;
     float link_line_segments_per_length;
     float link_hover_distance;
+    // The maximum distance in pixels between a link's curve and the line segments which it is drawn
+    // with, when StyleFlags_AdaptiveLinkFlattening is set.
+    float link_flattening_tolerance;
 
     // The following variables control the look and behavior of the pins. The default size of each
     // pin shape is balanced to occupy approximately the same surface area on the screen.
@@ -137,6 +195,17 @@ struct Style
     // Offsets the pins' positions from the edge of the node to the outside of the node.
     float pin_offset;
 
+    // Level of detail thresholds, in pixels, compared against the shorter side of a node on the
+    // screen. A node smaller than node_lod_chrome_size is drawn without its outline, rounded
+    // corners and pins, and its pins can't be hovered over. BeginNode() returns false for it if
+    // NodeFlags_CullOffscreen or NodeFlags_Cacheable is set, so that its contents are skipped,
+    // except once every 30 frames and after InvalidateNode(), when the contents are laid out
+    // without being drawn, so that the node's size follows them. A node smaller than
+    // node_lod_rect_size is drawn as a single filled rectangle. Set both to zero to always draw
+    // nodes in full.
+    float node_lod_chrome_size;
+    float node_lod_rect_size;
+
     // By default, StyleFlags_NodeOutline and StyleFlags_Gridlines are enabled.
     StyleFlags flags;
     // Set these mid-frame using Push/PopColorStyle. You can index this color array with with a
@@ -160,7 +229,23 @@ ImVec2 EditorContextGetPanning();
 void EditorContextResetPanning(const ImVec2& pos);
 void EditorContextMoveToNode(const int node_id);
 
-// Initialize the node editor system.
+// A context holds the style, the IO settings and the state of the frame being built, as well as
+// a default editor context. These functions mirror ImGui::CreateContext() and friends:
+// CreateContext() only makes the new context current if there is no current context, and
+// DestroyContext() destroys the current context by default.
+//
+// Independent node editors can be built on several threads at the same time, as long as each
+// thread uses its own imnodes context and its own ImGui context. Define IMNODES_THREAD_LOCAL
+// (for instance as thread_local) when compiling imnodes.cpp to make the current context
+// thread-local, the same way GImGui can be made thread-local in imconfig.h.
+struct Context;
+
+Context* CreateContext();
+void DestroyContext(Context* ctx = NULL);
+Context* GetCurrentContext();
+void SetCurrentContext(Context* ctx);
+
+// Initialize the node editor system. Equivalent to CreateContext() and DestroyContext().
 void Initialize();
 void Shutdown();
 
@@ -184,8 +269,40 @@ void PopColorStyle();
 void PushStyleVar(StyleVar style_item, float value);
 void PopStyleVar();
 
-void BeginNode(int id);
+// Begin a node. The flags argument is a combination of NodeFlags values. Returns false if the node
+// was culled, in which case its contents should be skipped and EndNode() should not be called:
+//
+//   if (imnodes::BeginNode(id, imnodes::NodeFlags_CullOffscreen))
+//   {
+//       ...
+//       imnodes::EndNode();
+//   }
+//
+// BeginNode() always returns true when neither NodeFlags_CullOffscreen nor NodeFlags_Cacheable is
+// set.
+bool BeginNode(int id, int flags = NodeFlags_None);
 void EndNode();
+// Discard the recorded output of a NodeFlags_Cacheable node, so that its contents are submitted
+// again during the next frame. The contents of a node which is too small to be drawn in full are
+// submitted during the next frame as well.
+void InvalidateNode(int node_id);
+
+// A pin of a node submitted with ProxyNode().
+struct ProxyPin
+{
+    int id;
+    PinShape shape;
+    // Output pins are placed on the right side of the node, and input pins on the left side.
+    bool output;
+};
+
+// Submit a node which only consists of a single line title and pins, in a single call. Call this
+// instead of BeginNode()/EndNode(). The node is drawn directly into the editor canvas without
+// creating any ImGui items, which makes it much cheaper to submit than a regular node. The size is
+// the size of the whole node in pixels. The pins are placed one text line apart below the title
+// bar, and the current attribute flags apply to them. Proxy nodes outside of the canvas are always
+// culled.
+void ProxyNode(int id, const char* title, const ImVec2& size, const ProxyPin* pins, int num_pins);
 
 // Place your node title bar content (such as the node title, using ImGui::Text) between the
 // following function calls. These functions have to be called before adding any attributes, or the
@@ -224,6 +341,10 @@ void PopAttributeFlag();
 // The attributes ids used here must match the ids used in Begin(Input|Output)Attribute function
 // calls. The order of start_attr and end_attr doesn't make a difference for rendering the link.
 void Link(int id, int start_attribute_id, int end_attribute_id);
+// Returns true if a link between the two attributes has been submitted with Link() during the
+// current frame. The order of the attributes doesn't matter. Call this after the links have been
+// submitted, for instance after EndNodeEditor().
+bool HasLink(int start_attribute_id, int end_attribute_id);
 
 // Set's the node's position corresponding to the node id, either using screen space coordinates, or
 // node editor grid coordinates. You can even set the position before the node has been created with
@@ -295,4 +416,33 @@ void SaveEditorStateToIniFile(const EditorContext* editor, const char* file_name
 
 void LoadCurrentEditorStateFromIniFile(const char* file_name);
 void LoadEditorStateFromIniFile(EditorContext* editor, const char* file_name);
+
+// Use the following functions to load the INI state in chunks, for example while a large file is
+// still being read. The data may be split anywhere, even in the middle of a line. Don't draw the
+// editor between the calls to BeginLoadEditorStateFromIni() and EndLoadEditorStateFromIni().
+
+void BeginLoadCurrentEditorStateFromIni();
+void BeginLoadEditorStateFromIni(EditorContext* editor);
+void LoadEditorStateFromIniChunk(const char* data, size_t data_size);
+void EndLoadEditorStateFromIni();
+
+// Use the following functions to save and load the editor context's state in a compact binary
+// format. The state holds the same node positions and panning as the INI format, without rounding,
+// along with the ids of the selected nodes. The returned data is valid until the next save.
+//
+// The data is read in place, so it can point directly into a memory-mapped file. It uses the byte
+// order of the machine which saved it. The load functions return false, and leave the editor
+// unchanged, if the data isn't valid binary editor state of a supported version.
+
+const void* SaveCurrentEditorStateToBinary(size_t* data_size = NULL);
+const void* SaveEditorStateToBinary(const EditorContext* editor, size_t* data_size = NULL);
+
+bool LoadCurrentEditorStateFromBinary(const void* data, size_t data_size);
+bool LoadEditorStateFromBinary(EditorContext* editor, const void* data, size_t data_size);
+
+void SaveCurrentEditorStateToBinaryFile(const char* file_name);
+void SaveEditorStateToBinaryFile(const EditorContext* editor, const char* file_name);
+
+bool LoadCurrentEditorStateFromBinaryFile(const char* file_name);
+bool LoadEditorStateFromBinaryFile(EditorContext* editor, const char* file_name);
 } // namespace imnodes
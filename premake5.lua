@@ -81,6 +81,24 @@ function imnodes_example_project(name, example_file)
         links { "dl" }
 end
 
+-- The test programs include imnodes.cpp directly, so that they can test its internal functions.
+-- They don't need a window, so they only link against imgui.
+function imnodes_test_project(name, test_file)
+    project(name)
+    location(projectlocation)
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++11"
+    targetdir "bin/%{cfg.buildcfg}"
+    debugdir "bin/%{cfg.buildcfg}"
+    files { "tests/imnodes_test.h", path.join("tests", test_file) }
+    includedirs {
+        os.getcwd(),
+        imguilocation,
+    }
+    links { "imgui" }
+end
+
 workspace "imnodes"
     configurations { "Debug", "Release" }
     architecture "x86_64"
@@ -150,3 +168,12 @@ workspace "imnodes"
     imnodes_example_project("colornode", "color_node_editor.cpp")
 
     imnodes_example_project("multieditor", "multi_editor.cpp")
+
+    group "tests"
+
+    imnodes_test_project("bench_index_map", "bench_index_map.cpp")
+    imnodes_test_project("bench_link_flattening", "bench_link_flattening.cpp")
+    imnodes_test_project("test_binary_state", "test_binary_state.cpp")
+    imnodes_test_project("test_closest_point", "test_closest_point.cpp")
+    imnodes_test_project("test_ini_state", "test_ini_state.cpp")
+    imnodes_test_project("test_node_lod", "test_node_lod.cpp")
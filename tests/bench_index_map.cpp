@@ -0,0 +1,260 @@
+// Compares IndexMap, which maps object ids to pool indices, with ImGuiStorage, the sorted array
+// which the object pools used before it: the time per insert and per lookup, for sequential and
+// random ids. Also checks IndexMap against a reference under random inserts, erases and lookups.
+// Some keys hash to the end of the table, so that the backward shift deletion also runs in
+// clusters which wrap around.
+
+#include "imnodes_test.h"
+
+#include <time.h>
+
+namespace
+{
+const int num_bench_ids = 20000;
+const int num_map_rounds = 200;
+const int num_storage_rounds = 5;
+
+double elapsed_ns(const clock_t start, const int num_operations)
+{
+    return 1e9 * (double)(clock() - start) / CLOCKS_PER_SEC / num_operations;
+}
+
+// Returns true if the key's slot is within 4 slots of the end of every table of 8 to 65536
+// entries. The probe sequences of such keys wrap around the end of the table.
+template<typename Key>
+bool is_near_table_end(const Key key)
+{
+    return ((imnodes::hash_key(key) + 4u) & 0xffffu) < 8u;
+}
+
+// Returns a random key which isn't in keys yet.
+int make_int_key(imnodes_test::Random& random, const ImVector<int>& keys, const bool near_end)
+{
+    for (;;)
+    {
+        const int key = (int)(random.next() << 8 ^ random.next());
+        if (keys.contains(key) || (near_end && !is_near_table_end(key)))
+        {
+            continue;
+        }
+        return key;
+    }
+}
+
+// Returns a random pair of pin ids, like the keys of the editor's link map, which isn't in keys
+// yet.
+ImU64 make_pin_pair_key(
+    imnodes_test::Random& random,
+    const ImVector<ImU64>& keys,
+    const bool near_end)
+{
+    for (;;)
+    {
+        const ImU64 key = (ImU64)(random.next() % 65536u) << 32 | (ImU64)(random.next() % 65536u);
+        if (keys.contains(key) || (near_end && !is_near_table_end(key)))
+        {
+            continue;
+        }
+        return key;
+    }
+}
+
+// Applies random operations to an IndexMap and to a reference array, which holds the value of
+// keys[i] at index i, or -1. Every check_interval operations, every key is looked up. Returns the
+// number of checks at which the map disagreed with the reference.
+template<typename Key>
+int count_reference_mismatches(
+    const ImVector<Key>& keys,
+    const int num_operations,
+    const int check_interval,
+    imnodes_test::Random& random)
+{
+    imnodes::IndexMap<Key> map;
+    ImVector<int> reference;
+    reference.resize(keys.size());
+    for (int i = 0; i < reference.size(); ++i)
+    {
+        reference[i] = -1;
+    }
+    int reference_size = 0;
+
+    int num_mismatches = 0;
+    for (int operation = 0; operation < num_operations; ++operation)
+    {
+        const int k = (int)(random.next() % (ImU32)keys.size());
+        const ImU32 choice = random.next() % 1000u;
+        if (choice < 450u)
+        {
+            const int value = (int)(random.next() % 1000000u);
+            reference_size += reference[k] < 0;
+            reference[k] = value;
+            map.insert(keys[k], value);
+        }
+        else if (choice < 900u)
+        {
+            reference_size -= reference[k] >= 0;
+            reference[k] = -1;
+            map.erase(keys[k]);
+        }
+        else if (choice < 995u)
+        {
+            num_mismatches += map.find(keys[k]) != reference[k];
+        }
+        else if (choice < 999u)
+        {
+            map.reserve((int)(random.next() % (ImU32)(2 * keys.size())));
+        }
+        else
+        {
+            map.clear();
+            for (int i = 0; i < reference.size(); ++i)
+            {
+                reference[i] = -1;
+            }
+            reference_size = 0;
+        }
+
+        if (operation % check_interval == 0)
+        {
+            bool matches = map.size == reference_size;
+            for (int i = 0; i < keys.size(); ++i)
+            {
+                matches = matches && map.find(keys[i]) == reference[i];
+            }
+            num_mismatches += !matches;
+        }
+    }
+    return num_mismatches;
+}
+
+// Inserts the ids, and then looks them up in the order of lookup_ids. Prints the time per
+// operation for both containers, and returns true if they found the same values.
+bool bench_ids(const char* const name, const ImVector<int>& ids, const ImVector<int>& lookup_ids)
+{
+    long map_sum = 0;
+    clock_t start = clock();
+    for (int round = 0; round < num_map_rounds; ++round)
+    {
+        imnodes::IndexMap<int> map;
+        for (int i = 0; i < ids.size(); ++i)
+        {
+            map.insert(ids[i], i);
+        }
+        map_sum += map.size;
+    }
+    const double map_insert_ns = elapsed_ns(start, num_map_rounds * ids.size());
+
+    imnodes::IndexMap<int> map;
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        map.insert(ids[i], i);
+    }
+    start = clock();
+    for (int round = 0; round < num_map_rounds; ++round)
+    {
+        for (int i = 0; i < lookup_ids.size(); ++i)
+        {
+            map_sum += map.find(lookup_ids[i]);
+        }
+    }
+    const double map_find_ns = elapsed_ns(start, num_map_rounds * lookup_ids.size());
+
+    long storage_sum = 0;
+    start = clock();
+    for (int round = 0; round < num_storage_rounds; ++round)
+    {
+        ImGuiStorage storage;
+        for (int i = 0; i < ids.size(); ++i)
+        {
+            storage.SetInt((ImGuiID)ids[i], i);
+        }
+        storage_sum += storage.Data.size() * (num_map_rounds / num_storage_rounds);
+    }
+    const double storage_insert_ns = elapsed_ns(start, num_storage_rounds * ids.size());
+
+    ImGuiStorage storage;
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        storage.SetInt((ImGuiID)ids[i], i);
+    }
+    start = clock();
+    for (int round = 0; round < num_map_rounds; ++round)
+    {
+        for (int i = 0; i < lookup_ids.size(); ++i)
+        {
+            storage_sum += storage.GetInt((ImGuiID)lookup_ids[i], -1);
+        }
+    }
+    const double storage_find_ns = elapsed_ns(start, num_map_rounds * lookup_ids.size());
+
+    printf(
+        "%-12s IndexMap: %5.1f ns/insert, %5.1f ns/find   ImGuiStorage: %7.1f ns/insert, %5.1f "
+        "ns/find\n",
+        name,
+        map_insert_ns,
+        map_find_ns,
+        storage_insert_ns,
+        storage_find_ns);
+    return map_sum == storage_sum;
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+    imnodes_test::Random random(13u);
+
+    // Up to 16 keys of each set belong to the probe sequence around the end of the table. Half of
+    // the other int keys are sequential, as ids usually are, including negative ones.
+    const int key_counts[] = {16, 200, 3000};
+    int num_int_mismatches = 0;
+    int num_pin_pair_mismatches = 0;
+    for (int i = 0; i < IM_ARRAYSIZE(key_counts); ++i)
+    {
+        const int num_near_end_keys = ImMin(key_counts[i] / 2, 16);
+        ImVector<int> int_keys;
+        ImVector<ImU64> pin_pair_keys;
+        for (int k = 0; k < key_counts[i]; ++k)
+        {
+            const bool near_end = k < num_near_end_keys;
+            if (!near_end && k < key_counts[i] / 2 + num_near_end_keys)
+            {
+                int_keys.push_back(k - num_near_end_keys - 8);
+            }
+            else
+            {
+                int_keys.push_back(make_int_key(random, int_keys, near_end));
+            }
+            pin_pair_keys.push_back(make_pin_pair_key(random, pin_pair_keys, near_end));
+        }
+        const int check_interval = key_counts[i] < 1000 ? 1 : 97;
+        num_int_mismatches +=
+            count_reference_mismatches(int_keys, 200000, check_interval, random);
+        num_pin_pair_mismatches +=
+            count_reference_mismatches(pin_pair_keys, 200000, check_interval, random);
+    }
+    IMNODES_TEST_CHECK(num_int_mismatches == 0);
+    IMNODES_TEST_CHECK(num_pin_pair_mismatches == 0);
+
+    // Sequential ids, looked up in order, and random ids, looked up in a random order.
+    ImVector<int> sequential_ids;
+    for (int i = 0; i < num_bench_ids; ++i)
+    {
+        sequential_ids.push_back(i);
+    }
+    IMNODES_TEST_CHECK(bench_ids("sequential", sequential_ids, sequential_ids));
+
+    ImVector<int> random_ids;
+    for (int i = 0; i < num_bench_ids; ++i)
+    {
+        random_ids.push_back((int)(random.next() << 8 ^ random.next()));
+    }
+    ImVector<int> shuffled_ids = random_ids;
+    for (int i = shuffled_ids.size() - 1; i > 0; --i)
+    {
+        ImSwap(shuffled_ids[i], shuffled_ids[(int)(random.next() % (ImU32)(i + 1))]);
+    }
+    IMNODES_TEST_CHECK(bench_ids("random", random_ids, shuffled_ids));
+
+    return imnodes_test::end_test("bench_index_map");
+}
@@ -0,0 +1,138 @@
+// Compares the fixed and the adaptive link flattening modes: the number of points per link, the
+// largest distance between the flattened link and its curve, and the number of vertices which
+// drawing the links adds to the canvas.
+
+#include "imnodes_test.h"
+
+namespace
+{
+const int num_curves = 10000;
+const int num_measured_curves = 1000;
+// Few enough for the canvas to stay within 16-bit vertex indices.
+const int num_drawn_links = 100;
+
+struct FlatteningMode
+{
+    const char* name;
+    bool adaptive;
+    float tolerance;
+};
+
+float get_distance_to_polyline(const ImVec2& p, const ImVector<ImVec2>& points)
+{
+    float min_distance_sqr = FLT_MAX;
+    for (int i = 1; i < points.size(); ++i)
+    {
+        const ImVec2 closest = ImLineClosestPoint(points[i - 1], points[i], p);
+        min_distance_sqr = ImMin(min_distance_sqr, ImLengthSqr(closest - p));
+    }
+    return ImSqrt(min_distance_sqr);
+}
+
+// Draws pairs of linked proxy nodes, and returns the number of vertices in the draw data.
+int draw_linked_nodes(const bool draw_links)
+{
+    imnodes_test::begin_frame(ImVec2(-1.f, -1.f));
+    imnodes::BeginNodeEditor();
+    for (int i = 0; i < num_drawn_links; ++i)
+    {
+        const imnodes::ProxyPin output_pin = {2 * i, imnodes::PinShape_CircleFilled, true};
+        const imnodes::ProxyPin input_pin = {2 * i + 1, imnodes::PinShape_CircleFilled, false};
+        imnodes::ProxyNode(2 * i, "", ImVec2(20.f, 20.f), &output_pin, 1);
+        imnodes::ProxyNode(2 * i + 1, "", ImVec2(20.f, 20.f), &input_pin, 1);
+    }
+    for (int i = 0; draw_links && i < num_drawn_links; ++i)
+    {
+        imnodes::Link(i, 2 * i, 2 * i + 1);
+    }
+    imnodes::EndNodeEditor();
+    imnodes_test::end_frame();
+    return ImGui::GetDrawData()->TotalVtxCount;
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+
+    imnodes_test::Random random(3u);
+    for (int i = 0; i < 2 * num_drawn_links; ++i)
+    {
+        imnodes::SetNodeGridSpacePos(
+            i, ImVec2(random.range(0.f, 1880.f), random.range(0.f, 1040.f)));
+    }
+
+    const FlatteningMode modes[] = {
+        {"fixed", false, 0.f}, {"adaptive", true, 0.25f}, {"adaptive", true, 1.f}};
+    imnodes::Style& style = imnodes::GetStyle();
+    for (int mode_idx = 0; mode_idx < IM_ARRAYSIZE(modes); ++mode_idx)
+    {
+        const FlatteningMode& mode = modes[mode_idx];
+        if (mode.adaptive)
+        {
+            style.flags = imnodes::StyleFlags(
+                style.flags | imnodes::StyleFlags_AdaptiveLinkFlattening);
+            style.link_flattening_tolerance = mode.tolerance;
+        }
+        else
+        {
+            style.flags = imnodes::StyleFlags(
+                style.flags & ~imnodes::StyleFlags_AdaptiveLinkFlattening);
+        }
+
+        random = imnodes_test::Random(7u);
+        ImVector<ImVec2> points;
+        long total_points = 0;
+        float max_deviation = 0.f;
+        for (int i = 0; i < num_curves; ++i)
+        {
+            const ImVec2 start(random.range(0.f, 2000.f), random.range(0.f, 2000.f));
+            const ImVec2 end(random.range(0.f, 2000.f), random.range(0.f, 2000.f));
+            const imnodes::LinkBezierData link_data = imnodes::get_link_renderable(
+                start, end, imnodes::AttributeType_Output, style.link_line_segments_per_length);
+            imnodes::flatten_link(link_data, points);
+            total_points += points.size();
+
+            for (int sample = 0; i < num_measured_curves && sample <= 200; ++sample)
+            {
+                const ImVec2 on_curve = imnodes::eval_bezier(sample / 200.f, link_data.bezier);
+                max_deviation = ImMax(max_deviation, get_distance_to_polyline(on_curve, points));
+            }
+        }
+
+        if (mode.adaptive)
+        {
+            // The subdivision stops once the control points are within the tolerance of the chord,
+            // which bounds the distance between the polyline and the curve.
+            IMNODES_TEST_CHECK(max_deviation <= mode.tolerance * 1.01f);
+        }
+
+        // Draw twice, so that the link curves are cached, and subtract the nodes' vertices.
+        draw_linked_nodes(true);
+        const int link_vertices = draw_linked_nodes(true) - draw_linked_nodes(false);
+
+        char name[32];
+        if (mode.adaptive)
+        {
+            ImFormatString(
+                name, IM_ARRAYSIZE(name), "%s, tolerance %.2f", mode.name, mode.tolerance);
+        }
+        else
+        {
+            ImFormatString(
+                name,
+                IM_ARRAYSIZE(name),
+                "%s, %.2f segments/px",
+                mode.name,
+                style.link_line_segments_per_length);
+        }
+        printf(
+            "%-26s %6.1f points/link, max deviation %.2f px, %6.1f vertices/drawn link\n",
+            name,
+            (double)total_points / num_curves,
+            max_deviation,
+            (double)link_vertices / num_drawn_links);
+    }
+
+    return imnodes_test::end_test("bench_link_flattening");
+}
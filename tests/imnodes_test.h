@@ -0,0 +1,97 @@
+#pragma once
+
+// Shared by the test programs. Each program includes imnodes.cpp through this header, so that it
+// can call the functions which aren't part of the public API, and is linked against imgui only.
+
+#if defined(__GNUC__) && !defined(__clang__)
+// The editor's types have members from imnodes.cpp's anonymous namespace, which GCC warns about
+// once imnodes.cpp is included into another file.
+#pragma GCC diagnostic ignored "-Wsubobject-linkage"
+#endif
+
+#include "imnodes.cpp"
+
+#include <stdio.h>
+
+namespace imnodes_test
+{
+static int num_checks = 0;
+static int num_failures = 0;
+
+// A small deterministic random number generator, so that the results don't depend on the
+// platform's rand().
+struct Random
+{
+    ImU32 state;
+
+    Random(const ImU32 seed) : state(seed) {}
+
+    ImU32 next()
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Returns a float in [min, max).
+    float range(const float min, const float max)
+    {
+        return min + (max - min) * (float)next() / (float)(1u << 24);
+    }
+};
+
+// Creates the ImGui and imnodes contexts, and builds the font atlas so that frames can be
+// rendered without a backend.
+inline void begin_test()
+{
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1920.f, 1080.f);
+    io.DeltaTime = 1.f / 60.f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    imnodes::Initialize();
+}
+
+// Destroys the contexts and prints the results. Returns the process exit code.
+inline int end_test(const char* const name)
+{
+    imnodes::Shutdown();
+    ImGui::DestroyContext();
+    if (num_failures != 0)
+    {
+        printf("%s: %d of %d checks failed\n", name, num_failures, num_checks);
+        return 1;
+    }
+    printf("%s: all %d checks passed\n", name, num_checks);
+    return 0;
+}
+
+// Begins a frame with a window which fills the display, for the node editor to be drawn in.
+inline void begin_frame(const ImVec2& mouse_pos)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.MousePos = mouse_pos;
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("editor", NULL, ImGuiWindowFlags_NoDecoration);
+}
+
+inline void end_frame()
+{
+    ImGui::End();
+    ImGui::Render();
+}
+} // namespace imnodes_test
+
+#define IMNODES_TEST_CHECK(condition)                                                              \
+    do                                                                                             \
+    {                                                                                              \
+        ++imnodes_test::num_checks;                                                                \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                   \
+            ++imnodes_test::num_failures;                                                          \
+        }                                                                                          \
+    } while (0)
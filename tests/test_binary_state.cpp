@@ -0,0 +1,209 @@
+// Tests the binary editor state: the round trip through INI and binary state, the exact node
+// origins and selection after a binary round trip, and the rejection of invalid data.
+
+#include "imnodes_test.h"
+
+#include <stddef.h>
+
+namespace
+{
+const int num_nodes = 10000;
+
+void copy_data(const void* const data, const size_t data_size, ImVector<char>& out)
+{
+    out.resize((int)data_size);
+    memcpy(out.Data, data, data_size);
+}
+
+bool data_equal(const void* const data, const size_t data_size, const ImVector<char>& expected)
+{
+    return data_size == (size_t)expected.size() && memcmp(data, expected.Data, data_size) == 0;
+}
+
+// Fills the editor with nodes at origins which don't survive the INI format's rounding, and
+// selects every seventh node.
+void fill_editor(imnodes::EditorContext& editor)
+{
+    imnodes::EditorContextSet(&editor);
+    imnodes_test::Random random(11u);
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        imnodes::SetNodeGridSpacePos(
+            3 * i - 7, ImVec2(random.range(-5000.f, 5000.f), random.range(-5000.f, 5000.f)));
+    }
+    imnodes::EditorContextSet(imnodes::GImNodes->default_editor_ctx);
+    editor.panning = ImVec2(-123.375f, 45.1f);
+    for (int i = 0; i < num_nodes; i += 7)
+    {
+        editor.selected_node_indices.push_back(i);
+    }
+}
+
+bool is_editor_empty(const imnodes::EditorContext& editor)
+{
+    return editor.nodes.pool.size() == 0 && editor.selected_node_indices.size() == 0 &&
+           editor.panning.x == 0.f && editor.panning.y == 0.f;
+}
+
+// Returns true if the binary data is rejected, and leaves a new editor empty.
+bool is_rejected(const void* const data, const size_t data_size)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    const bool rejected = !imnodes::LoadEditorStateFromBinary(editor, data, data_size);
+    const bool empty = is_editor_empty(*editor);
+    imnodes::EditorContextFree(editor);
+    return rejected && empty;
+}
+
+// Returns true if the data is rejected after the header field at the offset has been overwritten
+// with the value.
+bool is_rejected_with_field(ImVector<char> data, const size_t offset, const ImU32 value)
+{
+    memcpy(data.Data + offset, &value, sizeof(value));
+    return is_rejected(data.Data, data.size());
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+
+    imnodes::EditorContext* const source = imnodes::EditorContextCreate();
+    fill_editor(*source);
+
+    // INI -> binary -> INI keeps everything the INI format holds.
+    {
+        size_t ini_size = 0u;
+        const char* ini = imnodes::SaveEditorStateToIniString(source, &ini_size);
+        ImVector<char> source_ini;
+        copy_data(ini, ini_size, source_ini);
+
+        imnodes::EditorContext* const from_ini = imnodes::EditorContextCreate();
+        imnodes::LoadEditorStateFromIniString(from_ini, source_ini.Data, source_ini.size());
+        size_t binary_size = 0u;
+        const void* binary = imnodes::SaveEditorStateToBinary(from_ini, &binary_size);
+        ImVector<char> from_ini_binary;
+        copy_data(binary, binary_size, from_ini_binary);
+
+        imnodes::EditorContext* const from_binary = imnodes::EditorContextCreate();
+        IMNODES_TEST_CHECK(imnodes::LoadEditorStateFromBinary(
+            from_binary, from_ini_binary.Data, from_ini_binary.size()));
+        binary = imnodes::SaveEditorStateToBinary(from_binary, &binary_size);
+        IMNODES_TEST_CHECK(data_equal(binary, binary_size, from_ini_binary));
+        ini = imnodes::SaveEditorStateToIniString(from_binary, &ini_size);
+        IMNODES_TEST_CHECK(data_equal(ini, ini_size, source_ini));
+
+        imnodes::EditorContextFree(from_binary);
+        imnodes::EditorContextFree(from_ini);
+    }
+
+    // A binary round trip keeps the exact origins and the selection.
+    size_t binary_size = 0u;
+    const void* binary = imnodes::SaveEditorStateToBinary(source, &binary_size);
+    ImVector<char> source_binary;
+    copy_data(binary, binary_size, source_binary);
+    {
+        imnodes::EditorContext* const loaded = imnodes::EditorContextCreate();
+        IMNODES_TEST_CHECK(imnodes::LoadEditorStateFromBinary(
+            loaded, source_binary.Data, source_binary.size()));
+        IMNODES_TEST_CHECK(
+            loaded->panning.x == source->panning.x && loaded->panning.y == source->panning.y);
+
+        int num_loaded_nodes = 0;
+        int num_exact_origins = 0;
+        for (int i = source->nodes.first_in_use(); i != -1; i = source->nodes.next_in_use(i))
+        {
+            const imnodes::NodeData& node = source->nodes.pool[i];
+            const int loaded_idx = loaded->nodes.id_map.find(node.id);
+            if (loaded_idx != -1)
+            {
+                const ImVec2 origin = loaded->nodes.pool[loaded_idx].origin;
+                ++num_loaded_nodes;
+                num_exact_origins += origin.x == node.origin.x && origin.y == node.origin.y;
+            }
+        }
+        IMNODES_TEST_CHECK(num_loaded_nodes == num_nodes);
+        IMNODES_TEST_CHECK(num_exact_origins == num_nodes);
+
+        const int num_selected = source->selected_node_indices.size();
+        IMNODES_TEST_CHECK(loaded->selected_node_indices.size() == num_selected);
+        int num_same_selected = 0;
+        for (int i = 0; i < num_selected && i < loaded->selected_node_indices.size(); ++i)
+        {
+            const int source_id = source->nodes.pool[source->selected_node_indices[i]].id;
+            const int loaded_id = loaded->nodes.pool[loaded->selected_node_indices[i]].id;
+            num_same_selected += source_id == loaded_id;
+        }
+        IMNODES_TEST_CHECK(num_same_selected == num_selected);
+
+        imnodes::EditorContextFree(loaded);
+    }
+
+    // Truncated data is rejected, whatever the length.
+    {
+        imnodes::EditorContext* const small = imnodes::EditorContextCreate();
+        imnodes::EditorContextSet(small);
+        for (int i = 0; i < 4; ++i)
+        {
+            imnodes::SetNodeGridSpacePos(i, ImVec2(10.f * i, 20.f * i));
+        }
+        imnodes::EditorContextSet(imnodes::GImNodes->default_editor_ctx);
+        small->selected_node_indices.push_back(1);
+        small->selected_node_indices.push_back(3);
+        binary = imnodes::SaveEditorStateToBinary(small, &binary_size);
+        ImVector<char> small_binary;
+        copy_data(binary, binary_size, small_binary);
+        imnodes::EditorContextFree(small);
+
+        int num_rejected = 0;
+        for (int size = 0; size < small_binary.size(); ++size)
+        {
+            num_rejected += is_rejected(small_binary.Data, (size_t)size);
+        }
+        IMNODES_TEST_CHECK(num_rejected == small_binary.size());
+        IMNODES_TEST_CHECK(is_rejected(NULL, 0u));
+    }
+
+    // Bad magic, unknown versions, and counts which don't fit in the data are rejected.
+    {
+        ImVector<char> bad_magic = source_binary;
+        bad_magic[0] = 'X';
+        IMNODES_TEST_CHECK(is_rejected(bad_magic.Data, bad_magic.size()));
+
+        const size_t version_offset = offsetof(imnodes::BinaryStateHeader, version);
+        IMNODES_TEST_CHECK(is_rejected_with_field(source_binary, version_offset, 0u));
+        IMNODES_TEST_CHECK(is_rejected_with_field(source_binary, version_offset, 2u));
+
+        const size_t node_count_offset = offsetof(imnodes::BinaryStateHeader, node_count);
+        IMNODES_TEST_CHECK(
+            is_rejected_with_field(source_binary, node_count_offset, (ImU32)num_nodes + 1u));
+        IMNODES_TEST_CHECK(is_rejected_with_field(source_binary, node_count_offset, 0xffffffffu));
+        IMNODES_TEST_CHECK(is_rejected_with_field(source_binary, node_count_offset, 0x80000000u));
+
+        const size_t selected_count_offset =
+            offsetof(imnodes::BinaryStateHeader, selected_node_count);
+        const ImU32 num_selected = (ImU32)source->selected_node_indices.size();
+        IMNODES_TEST_CHECK(
+            is_rejected_with_field(source_binary, selected_count_offset, num_selected + 1u));
+        IMNODES_TEST_CHECK(
+            is_rejected_with_field(source_binary, selected_count_offset, 0xffffffffu));
+
+        size_t ini_size = 0u;
+        const char* ini = imnodes::SaveEditorStateToIniString(source, &ini_size);
+        IMNODES_TEST_CHECK(is_rejected(ini, ini_size));
+    }
+
+    // A rejected load leaves an editor which already holds state unchanged.
+    {
+        imnodes::EditorContext* const loaded = imnodes::EditorContextCreate();
+        imnodes::LoadEditorStateFromBinary(loaded, source_binary.Data, source_binary.size());
+        IMNODES_TEST_CHECK(!imnodes::LoadEditorStateFromBinary(
+            loaded, source_binary.Data, source_binary.size() - 1));
+        binary = imnodes::SaveEditorStateToBinary(loaded, &binary_size);
+        IMNODES_TEST_CHECK(data_equal(binary, binary_size, source_binary));
+        imnodes::EditorContextFree(loaded);
+    }
+
+    imnodes::EditorContextFree(source);
+    return imnodes_test::end_test("test_binary_state");
+}
@@ -0,0 +1,108 @@
+// Compares get_closest_point_on_cubic_bezier() against the distance to a dense sampling of the
+// curve, and against the segment walk over the link's polyline which link hovering used before.
+// The new method must not be less accurate than the segment walk.
+
+#include "imnodes_test.h"
+
+namespace
+{
+const int num_queries = 20000;
+const int num_reference_samples = 10000;
+
+// The distance to the closest of a dense set of samples along the curve.
+float get_sampled_distance_to_cubic_bezier(const ImVec2& p, const imnodes::BezierCurve& bezier)
+{
+    float min_distance_sqr = FLT_MAX;
+    for (int i = 0; i <= num_reference_samples; ++i)
+    {
+        const ImVec2 on_curve = imnodes::eval_bezier(i / (float)num_reference_samples, bezier);
+        min_distance_sqr = ImMin(min_distance_sqr, ImLengthSqr(on_curve - p));
+    }
+    return ImSqrt(min_distance_sqr);
+}
+
+// The closest point along each segment of the link's polyline, as link hovering measured it
+// before the distance was computed against the curve itself.
+float get_distance_to_link_polyline(const ImVec2& p, const imnodes::LinkBezierData& link_data)
+{
+    float min_distance_sqr = FLT_MAX;
+    ImVec2 segment_start = link_data.bezier.p0;
+    for (int i = 1; i <= link_data.num_segments; ++i)
+    {
+        const ImVec2 segment_end =
+            imnodes::eval_bezier(i / (float)link_data.num_segments, link_data.bezier);
+        const ImVec2 closest = ImLineClosestPoint(segment_start, segment_end, p);
+        min_distance_sqr = ImMin(min_distance_sqr, ImLengthSqr(closest - p));
+        segment_start = segment_end;
+    }
+    return ImSqrt(min_distance_sqr);
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+    const imnodes::Style& style = imnodes::GetStyle();
+
+    // Query points within 20 px of random links. Links which run backwards loop around, and have
+    // several local minima.
+    imnodes_test::Random random(7u);
+    float max_error = 0.f;
+    float max_polyline_error = 0.f;
+    int num_hover_mismatches = 0;
+    int num_polyline_hover_mismatches = 0;
+    for (int i = 0; i < num_queries; ++i)
+    {
+        const ImVec2 start(random.range(0.f, 2000.f), random.range(0.f, 2000.f));
+        const ImVec2 end(random.range(0.f, 2000.f), random.range(0.f, 2000.f));
+        const imnodes::LinkBezierData link_data = imnodes::get_link_renderable(
+            start, end, imnodes::AttributeType_Output, style.link_line_segments_per_length);
+        const ImVec2 on_curve = imnodes::eval_bezier(random.range(0.f, 1.f), link_data.bezier);
+        const ImVec2 p = on_curve + ImVec2(random.range(-20.f, 20.f), random.range(-20.f, 20.f));
+
+        const float reference = get_sampled_distance_to_cubic_bezier(p, link_data.bezier);
+        const float distance = imnodes::get_distance_to_cubic_bezier(p, link_data.bezier);
+        const float polyline_distance = get_distance_to_link_polyline(p, link_data);
+        max_error = ImMax(max_error, ImFabs(distance - reference));
+        max_polyline_error = ImMax(max_polyline_error, ImFabs(polyline_distance - reference));
+
+        const bool hovered = reference < style.link_hover_distance;
+        num_hover_mismatches += (distance < style.link_hover_distance) != hovered;
+        num_polyline_hover_mismatches += (polyline_distance < style.link_hover_distance) != hovered;
+    }
+
+    printf("curve:    max error %.3f px, %d hover mismatches\n", max_error, num_hover_mismatches);
+    printf(
+        "polyline: max error %.3f px, %d hover mismatches\n",
+        max_polyline_error,
+        num_polyline_hover_mismatches);
+    IMNODES_TEST_CHECK(max_error <= max_polyline_error);
+    IMNODES_TEST_CHECK(max_error < 0.25f);
+    IMNODES_TEST_CHECK(num_hover_mismatches <= num_polyline_hover_mismatches);
+
+    // Points behind the ends of a link are closest to the endpoints.
+    const imnodes::LinkBezierData link_data = imnodes::get_link_renderable(
+        ImVec2(100.f, 100.f),
+        ImVec2(600.f, 400.f),
+        imnodes::AttributeType_Output,
+        style.link_line_segments_per_length);
+    const ImVec2 before_start =
+        imnodes::get_closest_point_on_cubic_bezier(ImVec2(90.f, 100.f), link_data.bezier);
+    const ImVec2 after_end =
+        imnodes::get_closest_point_on_cubic_bezier(ImVec2(610.f, 400.f), link_data.bezier);
+    IMNODES_TEST_CHECK(before_start.x == 100.f && before_start.y == 100.f);
+    IMNODES_TEST_CHECK(after_end.x == 600.f && after_end.y == 400.f);
+
+    // Newton's method used to converge here, and then bisect away from the minimum.
+    const imnodes::LinkBezierData looping_link_data = imnodes::get_link_renderable(
+        ImVec2(1223.f, 1365.f),
+        ImVec2(156.f, 1518.f),
+        imnodes::AttributeType_Output,
+        style.link_line_segments_per_length);
+    const ImVec2 p(1120.63342f, 1395.43433f);
+    const float distance = imnodes::get_distance_to_cubic_bezier(p, looping_link_data.bezier);
+    IMNODES_TEST_CHECK(
+        distance - get_sampled_distance_to_cubic_bezier(p, looping_link_data.bezier) < 0.01f);
+
+    return imnodes_test::end_test("test_closest_point");
+}
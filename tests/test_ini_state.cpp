@@ -0,0 +1,284 @@
+// Tests loading the INI editor state: the number parsers against the C library, and loading in
+// chunks against loading all at once, for every way of splitting the data.
+
+#include "imnodes_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+// CRLF and LF line endings, a comment, hexadecimal, octal and negative node ids, an unknown
+// section, and no newline at the end.
+const char ini_data[] =
+    "; saved by a test\r\n"
+    "[editor]\r\n"
+    "panning=-12,34.5\r\n"
+    "\r\n"
+    "[node.1]\r\n"
+    "origin=1.5,-2.25\r\n"
+    "[node.0x1F]\r\n"
+    "origin=1e2,3.0E-1\r\n"
+    "[node.017]\n"
+    "origin=-0.001,7\n"
+    "[node.-3]\n"
+    "origin=100,200\n"
+    "[unknown]\n"
+    "origin=9,9\n"
+    "[node.2]\n"
+    "origin=0.1,123456789";
+const size_t ini_data_size = sizeof(ini_data) - 1;
+
+bool has_node_origin(const imnodes::EditorContext& editor, const int node_id, const ImVec2& origin)
+{
+    const int node_idx = editor.nodes.id_map.find(node_id);
+    return node_idx != -1 && editor.nodes.pool[node_idx].origin.x == origin.x &&
+           editor.nodes.pool[node_idx].origin.y == origin.y;
+}
+
+// The binary state holds the exact panning and node origins, so equal editors save equal data.
+void save_binary(const imnodes::EditorContext* const editor, ImVector<char>& out)
+{
+    size_t data_size = 0u;
+    const void* const data = imnodes::SaveEditorStateToBinary(editor, &data_size);
+    out.resize((int)data_size);
+    memcpy(out.Data, data, data_size);
+}
+
+// Loads the data in chunks of chunk_size bytes, except for the first chunk, which holds
+// first_chunk_size bytes.
+void load_in_chunks(
+    imnodes::EditorContext* const editor,
+    const size_t first_chunk_size,
+    const size_t chunk_size)
+{
+    imnodes::BeginLoadEditorStateFromIni(editor);
+    imnodes::LoadEditorStateFromIniChunk(ini_data, first_chunk_size);
+    for (size_t offset = first_chunk_size; offset < ini_data_size; offset += chunk_size)
+    {
+        imnodes::LoadEditorStateFromIniChunk(
+            ini_data + offset, ImMin(chunk_size, ini_data_size - offset));
+    }
+    imnodes::EndLoadEditorStateFromIni();
+}
+
+// Returns true if loading the data in chunks gives the same editor state as loading it at once.
+bool loads_like_one_shot(
+    const size_t first_chunk_size,
+    const size_t chunk_size,
+    const ImVector<char>& one_shot_binary)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    load_in_chunks(editor, first_chunk_size, chunk_size);
+    ImVector<char> binary;
+    save_binary(editor, binary);
+    imnodes::EditorContextFree(editor);
+    return imnodes::GImNodes->ini_load.partial_line.empty() &&
+           binary.size() == one_shot_binary.size() &&
+           memcmp(binary.Data, one_shot_binary.Data, binary.size()) == 0;
+}
+
+// Returns true if parse_ini_int() parses the string like strtol() with base 0, which is what
+// sscanf's %i does.
+bool parses_int_like_strtol(const char* const string)
+{
+    const char* const end = string + strlen(string);
+    int value = 0;
+    const char* const parsed_end = imnodes::parse_ini_int(string, end, &value);
+    char* expected_end = NULL;
+    const long expected = strtol(string, &expected_end, 0);
+    if (expected_end == string)
+    {
+        return parsed_end == NULL;
+    }
+    return parsed_end == expected_end && value == (int)expected;
+}
+
+// Returns true if parse_ini_float() parses the string to the same float as strtof(), bit for bit.
+bool parses_float_like_strtof(const char* const string)
+{
+    const char* const end = string + strlen(string);
+    float value = 0.f;
+    const char* const parsed_end = imnodes::parse_ini_float(string, end, &value);
+    char* expected_end = NULL;
+    const float expected = strtof(string, &expected_end);
+    if (expected_end == string)
+    {
+        return parsed_end == NULL;
+    }
+    return parsed_end == expected_end && memcmp(&value, &expected, sizeof(value)) == 0;
+}
+
+// Writes a random decimal number, with up to 12 digits before and after the decimal point, and an
+// optional exponent.
+void write_random_number(imnodes_test::Random& random, char* out)
+{
+    const char* const signs[] = {"", "-", "+"};
+    out += sprintf(out, "%s", signs[random.next() % 3u]);
+    const int integer_digits = (int)(random.next() % 13u);
+    const int fraction_digits = (int)(random.next() % 13u);
+    for (int i = 0; i < integer_digits; ++i)
+    {
+        *out++ = (char)('0' + random.next() % 10u);
+    }
+    if (fraction_digits > 0 || integer_digits == 0)
+    {
+        *out++ = '.';
+    }
+    for (int i = 0; i < fraction_digits || (i == 0 && integer_digits == 0); ++i)
+    {
+        *out++ = (char)('0' + random.next() % 10u);
+    }
+    if (random.next() % 2u == 0u)
+    {
+        out += sprintf(out, "e%d", (int)(random.next() % 61u) - 30);
+    }
+    *out = '\0';
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+
+    // Integers, including the prefixes and the invalid input which sscanf's %i handles.
+    const char* const ints[] = {"0",          "42",          "-7",         "+5",   "  12",  "0x1F",
+                                "0X1f",       "-0x10",       "017",        "-017", "08",    "0x",
+                                "0xg",        "x",           "-",          "",     "12]",   "1.5",
+                                "2147483647", "-2147483648", "0x7fffffff", "077"};
+    int num_ints_like_strtol = 0;
+    for (int i = 0; i < IM_ARRAYSIZE(ints); ++i)
+    {
+        num_ints_like_strtol += parses_int_like_strtol(ints[i]);
+    }
+    IMNODES_TEST_CHECK(num_ints_like_strtol == IM_ARRAYSIZE(ints));
+
+    // Floats, first written by hand, then random decimal numbers and printed random floats.
+    const char* const floats[] = {"0",
+                                  "-0",
+                                  "1.5",
+                                  ".5",
+                                  "5.",
+                                  "-2.25",
+                                  "1e2",
+                                  "3.0E-1",
+                                  "1e",
+                                  "1e+",
+                                  "0.1",
+                                  "123456789",
+                                  "16777217",
+                                  "33554431.5",
+                                  "1.0000001",
+                                  "0.30000000000000004441",
+                                  "9.999999e-11",
+                                  "1e-45",
+                                  "3.5e38",
+                                  "1e39",
+                                  "inf",
+                                  "-nan",
+                                  "0x1p3",
+                                  ".",
+                                  "-",
+                                  "",
+                                  "  7",
+                                  "7,8"};
+    int num_floats_like_strtof = 0;
+    for (int i = 0; i < IM_ARRAYSIZE(floats); ++i)
+    {
+        num_floats_like_strtof += parses_float_like_strtof(floats[i]);
+    }
+    IMNODES_TEST_CHECK(num_floats_like_strtof == IM_ARRAYSIZE(floats));
+
+    imnodes_test::Random random(5u);
+    const int num_random_floats = 500000;
+    char string[64];
+    int num_random_like_strtof = 0;
+    for (int i = 0; i < num_random_floats; ++i)
+    {
+        write_random_number(random, string);
+        num_random_like_strtof += parses_float_like_strtof(string);
+    }
+    IMNODES_TEST_CHECK(num_random_like_strtof == num_random_floats);
+
+    const char* const formats[] = {"%.9g", "%g", "%f", "%.1f", "%.3f", "%.0f"};
+    int num_printed_like_strtof = 0;
+    for (int i = 0; i < num_random_floats; ++i)
+    {
+        ImU32 bits = random.next() << 8 | (random.next() & 0xffu);
+        float number;
+        memcpy(&number, &bits, sizeof(number));
+        if (number != number || ImFabs(number) > 1e30f)
+        {
+            number = random.range(-10000.f, 10000.f);
+        }
+        ImFormatString(
+            string, IM_ARRAYSIZE(string), formats[i % IM_ARRAYSIZE(formats)], (double)number);
+        num_printed_like_strtof += parses_float_like_strtof(string);
+    }
+    IMNODES_TEST_CHECK(num_printed_like_strtof == num_random_floats);
+
+    // Decimal numbers next to the midpoint between two floats. Rounding them to a double first
+    // often lands exactly on the midpoint, which then rounds to the wrong float.
+    int num_midpoints_like_strtof = 0;
+    for (int i = 0; i < num_random_floats; ++i)
+    {
+        const float number = random.range(0.001f, 1000000.f);
+        ImU32 bits;
+        memcpy(&bits, &number, sizeof(bits));
+        ++bits;
+        float next_number;
+        memcpy(&next_number, &bits, sizeof(next_number));
+        const double midpoint = 0.5 * ((double)number + (double)next_number);
+        ImFormatString(string, IM_ARRAYSIZE(string), "%.*g", 15 + i % 3, midpoint);
+        num_midpoints_like_strtof += parses_float_like_strtof(string);
+    }
+    IMNODES_TEST_CHECK(num_midpoints_like_strtof == num_random_floats);
+
+    // Loading the data all at once.
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::LoadEditorStateFromIniString(editor, ini_data, ini_data_size);
+    IMNODES_TEST_CHECK(editor->panning.x == -12.f && editor->panning.y == 34.5f);
+    IMNODES_TEST_CHECK(has_node_origin(*editor, 1, ImVec2(1.5f, -2.25f)));
+    IMNODES_TEST_CHECK(has_node_origin(*editor, 31, ImVec2(100.f, 0.3f)));
+    IMNODES_TEST_CHECK(has_node_origin(*editor, 15, ImVec2(-0.001f, 7.f)));
+    IMNODES_TEST_CHECK(has_node_origin(*editor, -3, ImVec2(100.f, 200.f)));
+    IMNODES_TEST_CHECK(has_node_origin(*editor, 2, ImVec2(0.1f, 123456789.f)));
+    IMNODES_TEST_CHECK(editor->nodes.id_map.find(9) == -1);
+    ImVector<char> one_shot_binary;
+    save_binary(editor, one_shot_binary);
+    imnodes::EditorContextFree(editor);
+
+    // Split in two at every position, and in chunks of every size.
+    int num_splits_like_one_shot = 0;
+    for (size_t split = 0u; split <= ini_data_size; ++split)
+    {
+        num_splits_like_one_shot +=
+            loads_like_one_shot(split, ImMax(ini_data_size - split, (size_t)1u), one_shot_binary);
+    }
+    IMNODES_TEST_CHECK(num_splits_like_one_shot == (int)ini_data_size + 1);
+
+    int num_chunk_sizes_like_one_shot = 0;
+    for (size_t chunk_size = 1u; chunk_size <= ini_data_size; ++chunk_size)
+    {
+        num_chunk_sizes_like_one_shot +=
+            loads_like_one_shot(chunk_size, chunk_size, one_shot_binary);
+    }
+    IMNODES_TEST_CHECK(num_chunk_sizes_like_one_shot == (int)ini_data_size);
+
+    // The chunks can also be handed to the chunk loader directly, ending the data with an empty
+    // last chunk.
+    imnodes::IniLoadState state;
+    state.editor = imnodes::EditorContextCreate();
+    for (size_t offset = 0u; offset < ini_data_size; offset += 3u)
+    {
+        imnodes::ini_load_chunk(
+            state, ini_data + offset, ini_data + ImMin(offset + 3u, ini_data_size), false);
+    }
+    IMNODES_TEST_CHECK(!state.partial_line.empty());
+    imnodes::ini_load_chunk(state, NULL, NULL, true);
+    IMNODES_TEST_CHECK(state.partial_line.empty());
+    IMNODES_TEST_CHECK(has_node_origin(*state.editor, 2, ImVec2(0.1f, 123456789.f)));
+    imnodes::EditorContextFree(state.editor);
+
+    return imnodes_test::end_test("test_ini_state");
+}
@@ -0,0 +1,146 @@
+// Tests the level of detail of small nodes: the contents of a node which is too small to be drawn
+// in full are still laid out every few frames, so the node is drawn in full again once it grows,
+// and the pins which aren't drawn can't be hovered over. The contents of small nodes are refreshed
+// on different frames.
+
+#include "imnodes_test.h"
+
+namespace
+{
+const int node_id = 1;
+const int pin_id = 2;
+
+ImVec2 node_content_size(5.f, 5.f);
+int num_vertices = 0;
+
+// Submits a node which culls its contents, and returns the value BeginNode() returned.
+bool submit_frame(const ImVec2& mouse_pos)
+{
+    imnodes_test::begin_frame(mouse_pos);
+    imnodes::BeginNodeEditor();
+    const bool contents_submitted = imnodes::BeginNode(node_id, imnodes::NodeFlags_CullOffscreen);
+    if (contents_submitted)
+    {
+        imnodes::BeginOutputAttribute(pin_id);
+        ImGui::Button("##content", node_content_size);
+        imnodes::EndOutputAttribute();
+        imnodes::EndNode();
+    }
+    imnodes::EndNodeEditor();
+    imnodes_test::end_frame();
+    num_vertices = ImGui::GetDrawData()->TotalVtxCount;
+    return contents_submitted;
+}
+
+bool is_pin_hovered()
+{
+    int hovered_pin_id = -1;
+    return imnodes::IsPinHovered(&hovered_pin_id) && hovered_pin_id == pin_id;
+}
+
+// Submits count small nodes in a row, and returns the number of nodes whose contents were
+// submitted.
+int submit_small_nodes(const int count)
+{
+    imnodes_test::begin_frame(ImVec2(-1.f, -1.f));
+    imnodes::BeginNodeEditor();
+    int num_contents_submitted = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (imnodes::BeginNode(100 + i, imnodes::NodeFlags_CullOffscreen))
+        {
+            ImGui::Button("##content", ImVec2(5.f, 5.f));
+            imnodes::EndNode();
+            ++num_contents_submitted;
+        }
+    }
+    imnodes::EndNodeEditor();
+    imnodes_test::end_frame();
+    return num_contents_submitted;
+}
+
+ImVec2 get_pin_pos()
+{
+    imnodes::EditorContext& editor = imnodes::editor_context_get();
+    return editor.pins.pool[editor.pins.id_map.find(pin_id)].pos;
+}
+} // namespace
+
+int main()
+{
+    imnodes_test::begin_test();
+    imnodes::Style& style = imnodes::GetStyle();
+    style.node_padding_horizontal = 2.f;
+    style.node_padding_vertical = 2.f;
+    imnodes::SetNodeGridSpacePos(node_id, ImVec2(100.f, 100.f));
+    const ImVec2 no_mouse(-1.f, -1.f);
+
+    // The first submission lays the node out. After that, its contents are skipped.
+    IMNODES_TEST_CHECK(submit_frame(no_mouse));
+    IMNODES_TEST_CHECK(!submit_frame(no_mouse));
+    const int skipped_frame_vertices = num_vertices;
+
+    // The small node's pin isn't drawn, so it can't be hovered over.
+    submit_frame(get_pin_pos());
+    IMNODES_TEST_CHECK(!is_pin_hovered());
+
+    // Once the contents grow, the node is laid out again within node_lod_max_skipped_frames. The
+    // node is still too small to be drawn in full, and the refreshed contents aren't drawn.
+    node_content_size.x = 100.f;
+    int num_skipped_frames = 0;
+    while (!submit_frame(no_mouse) && num_skipped_frames <= imnodes::node_lod_max_skipped_frames)
+    {
+        ++num_skipped_frames;
+    }
+    IMNODES_TEST_CHECK(num_skipped_frames < imnodes::node_lod_max_skipped_frames);
+    IMNODES_TEST_CHECK(num_vertices == skipped_frame_vertices);
+    IMNODES_TEST_CHECK(!submit_frame(no_mouse));
+
+    // Once the node has grown large enough, it's drawn in full.
+    node_content_size.y = 100.f;
+    num_skipped_frames = 0;
+    while (!submit_frame(no_mouse) && num_skipped_frames <= imnodes::node_lod_max_skipped_frames)
+    {
+        ++num_skipped_frames;
+    }
+    IMNODES_TEST_CHECK(num_skipped_frames < imnodes::node_lod_max_skipped_frames);
+    IMNODES_TEST_CHECK(submit_frame(no_mouse));
+    IMNODES_TEST_CHECK(num_vertices > skipped_frame_vertices);
+
+    // The pin of the node drawn in full can be hovered over.
+    submit_frame(get_pin_pos());
+    IMNODES_TEST_CHECK(is_pin_hovered());
+
+    // InvalidateNode() makes the next frame submit the contents of a small node.
+    node_content_size = ImVec2(5.f, 5.f);
+    submit_frame(no_mouse);
+    IMNODES_TEST_CHECK(!submit_frame(no_mouse));
+    imnodes::InvalidateNode(node_id);
+    IMNODES_TEST_CHECK(submit_frame(no_mouse));
+    IMNODES_TEST_CHECK(!submit_frame(no_mouse));
+
+    // Small nodes which were created together refresh their contents on different frames.
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+    const int num_small_nodes = 3 * imnodes::node_lod_max_skipped_frames;
+    for (int i = 0; i < num_small_nodes; ++i)
+    {
+        imnodes::SetNodeGridSpacePos(100 + i, ImVec2(20.f * (i % 30), 20.f * (i / 30)));
+    }
+    IMNODES_TEST_CHECK(submit_small_nodes(num_small_nodes) == num_small_nodes);
+    int num_refreshes = 0;
+    int max_refreshes_per_frame = 0;
+    for (int frame = 0; frame <= imnodes::node_lod_max_skipped_frames; ++frame)
+    {
+        const int num_frame_refreshes = submit_small_nodes(num_small_nodes);
+        num_refreshes += num_frame_refreshes;
+        max_refreshes_per_frame = ImMax(max_refreshes_per_frame, num_frame_refreshes);
+    }
+    IMNODES_TEST_CHECK(num_refreshes == num_small_nodes);
+    IMNODES_TEST_CHECK(
+        max_refreshes_per_frame <= num_small_nodes / imnodes::node_lod_max_skipped_frames);
+    imnodes::EditorContextSet(imnodes::GImNodes->default_editor_ctx);
+    imnodes::EditorContextFree(editor);
+
+    return imnodes_test::end_test("test_node_lod");
+}